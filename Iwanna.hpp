@@ -417,6 +417,17 @@ namespace Myspace {
                            ImVec2(-FLT_MIN, GetTextLineHeight() * 5),
                            ImGuiInputTextFlags_ReadOnly | ImGuiInputTextFlags_NoHorizontalScroll);
 
+        static bool packedMode = false;
+        Checkbox("Packed mode (length-framed)##Traditional", &packedMode);
+        if (packedMode && !KP.modulus.empty()) {
+            SameLine();
+            try {
+                Text("%zu byte(s) per value", RSAUtil::packedBytesPerValue(KP));
+            } catch (const std::exception&) {
+                TextUnformatted("invalid modulus");
+            }
+        }
+
         Separator();
         TextUnformatted("Encryption");
         Separator();
@@ -444,7 +455,8 @@ namespace Myspace {
                 resultType = ResultType::Error;
             } else {
                 try {
-                    const std::vector<long long> res = RSAUtil::encryptText(encrypt_buffer, KP);
+                    const std::vector<long long> res = packedMode ? RSAUtil::encryptTextPacked(encrypt_buffer, KP)
+                                                                  : RSAUtil::encryptText(encrypt_buffer, KP);
                     resultPrimary = detail::encodeCiphertextBase64(res);
                     resultSecondary = RSAUtil::ciphertextToString(res);
                     resultType = ResultType::CiphertextBase64;
@@ -486,7 +498,8 @@ namespace Myspace {
                 try {
                     const std::string cleaned = detail::sanitizeCipherInput(decrypt_buffer.c_str());
                     const std::vector<long long> ciphertext = detail::parseCiphertext(cleaned);
-                    const std::string decrypted = RSAUtil::decryptText(ciphertext, KP);
+                    const std::string decrypted = packedMode ? RSAUtil::decryptTextPacked(ciphertext, KP)
+                                                             : RSAUtil::decryptText(ciphertext, KP);
                     resultPrimary = decrypted;
                     resultSecondary = RSAUtil::ciphertextToString(ciphertext);
                     resultType = ResultType::Plaintext;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <stdexcept>
@@ -8,6 +9,47 @@
 #include <cstdint>
 #include <algorithm>
 #include <limits>
+#include <array>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <charconv>
+#include <chrono>
+#include <optional>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+
+// Allocator-aware overloads (std::pmr) are available when the standard library provides them.
+#if defined(__cpp_lib_memory_resource)
+#define RSAUTIL_HAS_PMR 1
+#else
+#define RSAUTIL_HAS_PMR 0
+#endif
+
+// Native 128-bit products back the legacy integer mode where the compiler provides them.
+#if defined(__SIZEOF_INT128__)
+#define RSAUTIL_HAS_INT128 1
+#else
+#define RSAUTIL_HAS_INT128 0
+#endif
 
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
@@ -15,6 +57,21 @@
 #include <openssl/err.h>
 #include <openssl/bio.h>
 #include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/async.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/provider.h>
+#include <openssl/param_build.h>
+#include <openssl/core_names.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // RSA helpers implemented on top of OpenSSL while keeping the original interfaces.
 namespace RSAUtil {
@@ -62,11 +119,53 @@ namespace RSAUtil {
             }
         };
         
+        struct EVPPKEYDeleter {
+            void operator()(EVP_PKEY* pkey) const noexcept {
+                EVP_PKEY_free(pkey);
+            }
+        };
+        
+        struct EVPPKEYCTXDeleter {
+            void operator()(EVP_PKEY_CTX* ctx) const noexcept {
+                EVP_PKEY_CTX_free(ctx);
+            }
+        };
+        
+        struct BNGENCBDeleter {
+            void operator()(BN_GENCB* cb) const noexcept {
+                BN_GENCB_free(cb);
+            }
+        };
+        
+        struct EVPCIPHERCTXDeleter {
+            void operator()(EVP_CIPHER_CTX* ctx) const noexcept {
+                EVP_CIPHER_CTX_free(ctx);
+            }
+        };
+
+        struct EVPMDCTXDeleter {
+            void operator()(EVP_MD_CTX* ctx) const noexcept {
+                EVP_MD_CTX_free(ctx);
+            }
+        };
+
+        struct ASYNCWAITCTXDeleter {
+            void operator()(ASYNC_WAIT_CTX* ctx) const noexcept {
+                ASYNC_WAIT_CTX_free(ctx);
+            }
+        };
+        
         using UniqueBN = std::unique_ptr<BIGNUM, BNDeleter>;
         using UniqueBNCTX = std::unique_ptr<BN_CTX, BNCTXDeleter>;
+        using UniqueBNGENCB = std::unique_ptr<BN_GENCB, BNGENCBDeleter>;
         using UniqueRSA = std::unique_ptr<::RSA, RSADeleter>;
         using UniqueOSSString = std::unique_ptr<char, OpenSSLStringDeleter>;
         using UniqueBIO = std::unique_ptr<BIO, BIODeleter>;
+        using UniqueEVPPKEY = std::unique_ptr<EVP_PKEY, EVPPKEYDeleter>;
+        using UniqueEVPPKEYCTX = std::unique_ptr<EVP_PKEY_CTX, EVPPKEYCTXDeleter>;
+        using UniqueEVPCIPHERCTX = std::unique_ptr<EVP_CIPHER_CTX, EVPCIPHERCTXDeleter>;
+        using UniqueEVPMDCTX = std::unique_ptr<EVP_MD_CTX, EVPMDCTXDeleter>;
+        using UniqueASYNCWAITCTX = std::unique_ptr<ASYNC_WAIT_CTX, ASYNCWAITCTXDeleter>;
         
         [[noreturn]] void throwOpenSSLError(const std::string& message) {
             unsigned long errCode = ERR_get_error();
@@ -125,23 +224,274 @@ namespace RSAUtil {
             return UniqueBIO(bio);
         }
         
-        UniqueRSA loadPublicKey(const std::string& publicKeyPem) {
-            UniqueBIO bio(makeBioFromString(publicKeyPem));
-            RSA* rsa = PEM_read_bio_RSA_PUBKEY(bio.get(), nullptr, nullptr, nullptr);
-            if (!rsa) {
-                throwOpenSSLError("failed to load public key");
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        // Dedicated library context with the default provider loaded and the RSA and SHA
+        // implementations fetched up front, so lookups never go through the global config/provider scan.
+        // Intentionally never freed: cached keys and contexts may outlive any static destructor.
+        struct LibraryContext {
+            OSSL_LIB_CTX* libctx = nullptr;
+            OSSL_PROVIDER* provider = nullptr;
+            std::vector<EVP_KEYMGMT*> keyManagers;
+            std::vector<EVP_ASYM_CIPHER*> ciphers;
+            std::vector<EVP_MD*> digests;
+            std::vector<EVP_CIPHER*> symmetricCiphers;
+
+            LibraryContext() {
+                libctx = OSSL_LIB_CTX_new();
+                if (!libctx) {
+                    throwOpenSSLError("failed to create OpenSSL library context");
+                }
+                provider = OSSL_PROVIDER_load(libctx, "default");
+                if (!provider) {
+                    throwOpenSSLError("failed to load OpenSSL default provider");
+                }
+                if (EVP_KEYMGMT* keymgmt = EVP_KEYMGMT_fetch(libctx, "RSA", nullptr)) {
+                    keyManagers.push_back(keymgmt);
+                }
+                if (EVP_ASYM_CIPHER* cipher = EVP_ASYM_CIPHER_fetch(libctx, "RSA", nullptr)) {
+                    ciphers.push_back(cipher);
+                }
+                for (const char* name : {"SHA1", "SHA256"}) {
+                    if (EVP_MD* md = EVP_MD_fetch(libctx, name, nullptr)) {
+                        digests.push_back(md);
+                    }
+                }
+                ERR_clear_error();
+            }
+
+            // Methods only some operations need (the hybrid envelope's AES-GCM, larger OAEP digests).
+            // Each first fetch of an algorithm class costs about a millisecond, so short-lived
+            // processes leave these to be fetched on first use.
+            void prefetchExtended() {
+                for (const char* name : {"SHA384", "SHA512"}) {
+                    if (EVP_MD* md = EVP_MD_fetch(libctx, name, nullptr)) {
+                        digests.push_back(md);
+                    }
+                }
+                if (EVP_CIPHER* cipher = EVP_CIPHER_fetch(libctx, "AES-256-GCM", nullptr)) {
+                    symmetricCiphers.push_back(cipher);
+                }
+                ERR_clear_error();
+            }
+        };
+
+        inline LibraryContext& libraryContextState() {
+            static LibraryContext* context = new LibraryContext();
+            return *context;
+        }
+
+        inline OSSL_LIB_CTX* libraryContext() {
+            return libraryContextState().libctx;
+        }
+#endif
+
+        inline UniqueEVPPKEY requireRsaKey(EVP_PKEY* pkey, const char* failure) {
+            if (!pkey) {
+                throwOpenSSLError(failure);
             }
-            return UniqueRSA(rsa);
+            UniqueEVPPKEY key(pkey);
+            if (EVP_PKEY_base_id(key.get()) != EVP_PKEY_RSA) {
+                throw std::runtime_error(std::string(failure) + ": not an RSA key");
+            }
+            return key;
+        }
+
+        inline UniqueEVPPKEY loadPublicKey(const std::string& publicKeyPem) {
+            UniqueBIO bio(makeBioFromString(publicKeyPem));
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            EVP_PKEY* pkey = PEM_read_bio_PUBKEY_ex(bio.get(), nullptr, nullptr, nullptr, libraryContext(), nullptr);
+#else
+            EVP_PKEY* pkey = PEM_read_bio_PUBKEY(bio.get(), nullptr, nullptr, nullptr);
+#endif
+            return requireRsaKey(pkey, "failed to load public key");
         }
         
-        UniqueRSA loadPrivateKey(const std::string& privateKeyPem) {
+        inline UniqueEVPPKEY loadPrivateKey(const std::string& privateKeyPem) {
             UniqueBIO bio(makeBioFromString(privateKeyPem));
-            RSA* rsa = PEM_read_bio_RSAPrivateKey(bio.get(), nullptr, nullptr, nullptr);
-            if (!rsa) {
-                throwOpenSSLError("failed to load private key");
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            EVP_PKEY* pkey = PEM_read_bio_PrivateKey_ex(bio.get(), nullptr, nullptr, nullptr, libraryContext(), nullptr);
+#else
+            EVP_PKEY* pkey = PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr);
+#endif
+            return requireRsaKey(pkey, "failed to load private key");
+        }
+        
+        enum class KeyOperation {
+            Encrypt,
+            Decrypt,
+            Sign,
+            Verify
+        };
+
+        // True while running inside an ASYNC_JOB started by FiberScheduler.
+        inline bool inFiber() noexcept {
+            return ASYNC_get_current_job() != nullptr;
+        }
+
+        // Yield point between RSA blocks and prime candidates: gives the thread back to the fiber
+        // scheduler when running inside a job, no-op otherwise.
+        inline void fiberYield() noexcept {
+            if (inFiber()) {
+                ASYNC_pause_job();
+            }
+        }
+
+        // Message digest for signatures (SHA-256), fetched once.
+        inline const EVP_MD* signatureDigest() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            static EVP_MD* md = [] {
+                EVP_MD* fetched = EVP_MD_fetch(libraryContext(), "SHA256", nullptr);
+                if (!fetched) {
+                    throwOpenSSLError("failed to fetch SHA-256");
+                }
+                return fetched;
+            }();
+            return md;
+#else
+            return EVP_sha256();
+#endif
+        }
+
+        // Hashes a message with a per-thread EVP_MD_CTX, so batches do not allocate per message.
+        inline unsigned int signatureHash(const uint8_t* data, size_t size, unsigned char* out) {
+            thread_local UniqueEVPMDCTX ctx(EVP_MD_CTX_new());
+            unsigned int length = 0;
+            if (!ctx ||
+                EVP_DigestInit_ex(ctx.get(), signatureDigest(), nullptr) != 1 ||
+                EVP_DigestUpdate(ctx.get(), data, size) != 1 ||
+                EVP_DigestFinal_ex(ctx.get(), out, &length) != 1) {
+                throwOpenSSLError("failed to hash message");
             }
-            return UniqueRSA(rsa);
+            return length;
         }
+
+        // Parsed key plus the EVP_PKEY_CTX objects already initialised for it. A context is leased
+        // to one thread for the duration of a call and returned afterwards, so each thread pays the
+        // provider fetch and padding setup once instead of once per block.
+        class KeyState {
+        public:
+            explicit KeyState(UniqueEVPPKEY pkey) : pkey_(std::move(pkey)) {
+                size_ = EVP_PKEY_size(pkey_.get());
+                if (size_ <= 0) {
+                    throw std::runtime_error("invalid RSA key size");
+                }
+            }
+
+            KeyState(const KeyState&) = delete;
+            KeyState& operator=(const KeyState&) = delete;
+
+            EVP_PKEY* pkey() const noexcept { return pkey_.get(); }
+            int size() const noexcept { return size_; }
+
+            class Lease {
+            public:
+                Lease(const KeyState& owner, KeyOperation operation, int padding)
+                    : owner_(owner), operation_(operation), padding_(padding),
+                      ctx_(owner.acquire(operation, padding)) {}
+                ~Lease() { owner_.release(operation_, padding_, std::move(ctx_)); }
+
+                Lease(const Lease&) = delete;
+                Lease& operator=(const Lease&) = delete;
+
+                EVP_PKEY_CTX* get() const noexcept { return ctx_.get(); }
+
+            private:
+                const KeyState& owner_;
+                KeyOperation operation_;
+                int padding_;
+                UniqueEVPPKEYCTX ctx_;
+            };
+
+        private:
+            struct Pool {
+                KeyOperation operation;
+                int padding;
+                std::vector<UniqueEVPPKEYCTX> idle;
+            };
+
+            UniqueEVPPKEYCTX acquire(KeyOperation operation, int padding) const {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (Pool& pool : pools_) {
+                        if (pool.operation == operation && pool.padding == padding && !pool.idle.empty()) {
+                            UniqueEVPPKEYCTX ctx = std::move(pool.idle.back());
+                            pool.idle.pop_back();
+                            return ctx;
+                        }
+                    }
+                }
+                return createContext(operation, padding);
+            }
+
+            void release(KeyOperation operation, int padding, UniqueEVPPKEYCTX ctx) const noexcept {
+                if (!ctx) {
+                    return;
+                }
+                try {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (Pool& pool : pools_) {
+                        if (pool.operation == operation && pool.padding == padding) {
+                            pool.idle.push_back(std::move(ctx));
+                            return;
+                        }
+                    }
+                    pools_.push_back(Pool{operation, padding, {}});
+                    pools_.back().idle.push_back(std::move(ctx));
+                } catch (...) {
+                    // Dropping the context only costs a re-initialisation next time.
+                }
+            }
+
+            UniqueEVPPKEYCTX createContext(KeyOperation operation, int padding) const {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+                UniqueEVPPKEYCTX ctx(EVP_PKEY_CTX_new_from_pkey(libraryContext(), pkey_.get(), nullptr));
+#else
+                UniqueEVPPKEYCTX ctx(EVP_PKEY_CTX_new(pkey_.get(), nullptr));
+#endif
+                if (!ctx) {
+                    throwOpenSSLError("failed to create EVP_PKEY_CTX");
+                }
+                int initialised = 0;
+                switch (operation) {
+                    case KeyOperation::Encrypt:
+                        initialised = EVP_PKEY_encrypt_init(ctx.get());
+                        break;
+                    case KeyOperation::Decrypt:
+                        initialised = EVP_PKEY_decrypt_init(ctx.get());
+                        break;
+                    case KeyOperation::Sign:
+                        initialised = EVP_PKEY_sign_init(ctx.get());
+                        break;
+                    case KeyOperation::Verify:
+                        initialised = EVP_PKEY_verify_init(ctx.get());
+                        break;
+                }
+                if (initialised != 1) {
+                    throwOpenSSLError("failed to initialise RSA operation");
+                }
+                if (EVP_PKEY_CTX_set_rsa_padding(ctx.get(), padding) != 1) {
+                    throwOpenSSLError("failed to set RSA padding");
+                }
+                if (operation == KeyOperation::Sign || operation == KeyOperation::Verify) {
+                    if (EVP_PKEY_CTX_set_signature_md(ctx.get(), signatureDigest()) != 1) {
+                        throwOpenSSLError("failed to set signature digest");
+                    }
+                    // Signing uses a digest-length salt; verification accepts any salt length.
+                    if (padding == RSA_PKCS1_PSS_PADDING &&
+                        EVP_PKEY_CTX_set_rsa_pss_saltlen(ctx.get(), operation == KeyOperation::Sign
+                                                             ? RSA_PSS_SALTLEN_DIGEST
+                                                             : RSA_PSS_SALTLEN_AUTO) != 1) {
+                        throwOpenSSLError("failed to set PSS salt length");
+                    }
+                }
+                return ctx;
+            }
+
+            UniqueEVPPKEY pkey_;
+            int size_ = 0;
+            mutable std::mutex mutex_;
+            mutable std::vector<Pool> pools_;
+        };
         
         int maxChunkSizeForPadding(int rsaSize, int padding) {
             switch (padding) {
@@ -158,335 +508,3596 @@ namespace RSAUtil {
             }
         }
     } // namespace detail
-    
-    inline void ensureOpenSSLInit() {
-#if OPENSSL_VERSION_NUMBER < 0x30000000L
-        static bool initialized = [] {
-            ERR_load_crypto_strings();
-            return true;
-        }();
-        (void)initialized;
-#endif
-    }
-    
-    inline KeyPair generateKeyPair() {
-        ensureOpenSSLInit();
-        
-        constexpr int kMaxAttempts = 32;
-        constexpr int kPrimeBits = 30; // ensures modulus fits into signed 64-bit range
-        
-        detail::UniqueBNCTX ctx(BN_CTX_new());
-        if (!ctx) {
-            detail::throwOpenSSLError("failed to create BN_CTX");
-        }
-        
-        for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
-            detail::UniqueBN p(BN_new());
-            detail::UniqueBN q(BN_new());
-            detail::UniqueBN n(BN_new());
-            detail::UniqueBN phi(BN_new());
-            detail::UniqueBN pMinus(BN_new());
-            detail::UniqueBN qMinus(BN_new());
-            detail::UniqueBN gcd(BN_new());
-            
-            if (!p || !q || !n || !phi || !pMinus || !qMinus || !gcd) {
-                detail::throwOpenSSLError("failed to allocate BIGNUM");
-            }
-            
-            if (BN_generate_prime_ex(p.get(), kPrimeBits, 0, nullptr, nullptr, nullptr) != 1) {
-                detail::throwOpenSSLError("failed to generate prime p");
-            }
-            if (BN_generate_prime_ex(q.get(), kPrimeBits, 0, nullptr, nullptr, nullptr) != 1) {
-                detail::throwOpenSSLError("failed to generate prime q");
-            }
-            if (BN_cmp(p.get(), q.get()) == 0) {
-                continue;
-            }
-            
-            if (BN_mul(n.get(), p.get(), q.get(), ctx.get()) != 1) {
-                detail::throwOpenSSLError("failed to compute modulus");
-            }
-            if (BN_num_bits(n.get()) > 63) {
-                continue;
+
+    // Parsed public key. The PEM text is decoded once; copies share the same OpenSSL key object
+    // and its pool of initialised operation contexts.
+    class PublicKey {
+    public:
+        PublicKey() = default;
+
+        explicit PublicKey(const std::string& publicKeyPem)
+            : state_(std::make_shared<detail::KeyState>(detail::loadPublicKey(publicKeyPem))) {}
+
+        explicit PublicKey(const PemKeyPair& keyPair)
+            : PublicKey(keyPair.publicKeyPem) {}
+
+        bool valid() const noexcept { return static_cast<bool>(state_); }
+        explicit operator bool() const noexcept { return valid(); }
+
+        // Modulus size in bytes, i.e. the length of every ciphertext block.
+        int size() const noexcept { return state_ ? state_->size() : 0; }
+        int keyBits() const noexcept { return size() * 8; }
+
+        EVP_PKEY* get() const { return state().pkey(); }
+
+        const detail::KeyState& state() const {
+            if (!state_) {
+                throw std::invalid_argument("public key is not loaded");
             }
-            
-            if (!BN_copy(pMinus.get(), p.get()) || BN_sub_word(pMinus.get(), 1) != 1) {
-                detail::throwOpenSSLError("failed to compute p-1");
+            return *state_;
+        }
+
+    private:
+        std::shared_ptr<const detail::KeyState> state_;
+    };
+
+    // Parsed private key, see PublicKey. Private-key operations are blinded by OpenSSL itself, which
+    // derives one blinding pair per key and refreshes it by squaring, recomputing it only every 32 uses;
+    // padding checks (including implicit rejection for PKCS#1 v1.5) stay inside the EVP provider.
+    class PrivateKey {
+    public:
+        PrivateKey() = default;
+
+        explicit PrivateKey(const std::string& privateKeyPem)
+            : state_(std::make_shared<detail::KeyState>(detail::loadPrivateKey(privateKeyPem))) {}
+
+        explicit PrivateKey(const PemKeyPair& keyPair)
+            : PrivateKey(keyPair.privateKeyPem) {}
+
+        bool valid() const noexcept { return static_cast<bool>(state_); }
+        explicit operator bool() const noexcept { return valid(); }
+
+        int size() const noexcept { return state_ ? state_->size() : 0; }
+        int keyBits() const noexcept { return size() * 8; }
+
+        EVP_PKEY* get() const { return state().pkey(); }
+
+        const detail::KeyState& state() const {
+            if (!state_) {
+                throw std::invalid_argument("private key is not loaded");
             }
-            if (!BN_copy(qMinus.get(), q.get()) || BN_sub_word(qMinus.get(), 1) != 1) {
-                detail::throwOpenSSLError("failed to compute q-1");
+            return *state_;
+        }
+
+    private:
+        std::shared_ptr<const detail::KeyState> state_;
+    };
+
+    struct KeyCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t size = 0;        // Parsed keys and legacy codebooks currently held
+        size_t capacity = 0;    // Limit per kind (public, private, codebook); 0 disables caching
+    };
+
+    namespace detail {
+        using PemDigest = std::array<unsigned char, 32>;
+
+        struct PemDigestHash {
+            size_t operator()(const PemDigest& digest) const noexcept {
+                size_t value = 0;
+                std::memcpy(&value, digest.data(), sizeof(value));
+                return value;
             }
-            if (BN_mul(phi.get(), pMinus.get(), qMinus.get(), ctx.get()) != 1) {
-                detail::throwOpenSSLError("failed to compute phi");
+        };
+
+        inline PemDigest digestPem(const std::string& pem) {
+            PemDigest digest{};
+            unsigned int length = 0;
+            if (EVP_Digest(pem.data(), pem.size(), digest.data(), &length, EVP_sha256(), nullptr) != 1 ||
+                length != digest.size()) {
+                throwOpenSSLError("failed to digest PEM text");
             }
-            
-            detail::UniqueBN e(detail::makeBNFromWord(65537));
-            if (BN_gcd(gcd.get(), e.get(), phi.get(), ctx.get()) != 1) {
-                detail::throwOpenSSLError("failed to compute gcd for exponent");
+            return digest;
+        }
+
+        // Bounded, thread-safe LRU map from PEM digest to a parsed key handle.
+        template <typename Key>
+        class KeyCache {
+        public:
+            explicit KeyCache(size_t capacity) : capacity_(capacity) {}
+
+            Key getOrLoad(const std::string& pem) {
+                return getOrLoad(pem, [&pem] { return Key(pem); });
             }
-            if (!BN_is_one(gcd.get())) {
-                static const unsigned long kFallbackExponents[] = {3UL, 5UL, 17UL, 257UL};
-                bool found = false;
-                for (unsigned long cand : kFallbackExponents) {
-                    if (BN_set_word(e.get(), cand) != 1) {
-                        detail::throwOpenSSLError("failed to set fallback exponent");
-                    }
-                    if (BN_gcd(gcd.get(), e.get(), phi.get(), ctx.get()) != 1) {
-                        detail::throwOpenSSLError("failed to compute gcd for fallback exponent");
+
+            // As above, with `load` producing the value for a missing `text`.
+            template <typename Load>
+            Key getOrLoad(const std::string& text, Load&& load) {
+                const PemDigest digest = digestPem(text);
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    auto found = index_.find(digest);
+                    if (found != index_.end()) {
+                        ++hits_;
+                        entries_.splice(entries_.begin(), entries_, found->second);
+                        return found->second->second;
                     }
-                    if (BN_is_one(gcd.get())) {
-                        found = true;
-                        break;
+                    ++misses_;
+                    if (capacity_ == 0) {
+                        return load();
                     }
                 }
-                if (!found) {
-                    continue;
+
+                // Parse outside the lock so a slow load does not serialise unrelated callers.
+                Key key = load();
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (capacity_ == 0 || index_.count(digest) != 0) {
+                    return key;
                 }
+                entries_.emplace_front(digest, key);
+                index_.emplace(digest, entries_.begin());
+                trimLocked();
+                return key;
             }
-            
-            BIGNUM* rawD = BN_mod_inverse(nullptr, e.get(), phi.get(), ctx.get());
-            if (!rawD) {
-                detail::throwOpenSSLError("failed to compute private exponent");
+
+            void setCapacity(size_t capacity) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                capacity_ = capacity;
+                trimLocked();
             }
-            detail::UniqueBN d(rawD);
-            
-            if (BN_num_bits(d.get()) > 63 || BN_num_bits(e.get()) > 32) {
-                continue;
+
+            void clear() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                entries_.clear();
+                index_.clear();
             }
-            
-            detail::UniqueOSSString nStr(BN_bn2dec(n.get()));
-            detail::UniqueOSSString dStr(BN_bn2dec(d.get()));
-            detail::UniqueOSSString eStr(BN_bn2dec(e.get()));
-            
-            if (!nStr || !dStr || !eStr) {
-                detail::throwOpenSSLError("failed to convert BIGNUM to string");
+
+            void addStats(KeyCacheStats& stats) const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats.hits += hits_;
+                stats.misses += misses_;
+                stats.evictions += evictions_;
+                stats.size += entries_.size();
+                stats.capacity = capacity_;
             }
-            
-            return {std::string(eStr.get()), std::string(dStr.get()), std::string(nStr.get())};
+
+        private:
+            void trimLocked() {
+                while (entries_.size() > capacity_) {
+                    index_.erase(entries_.back().first);
+                    entries_.pop_back();
+                    ++evictions_;
+                }
+            }
+
+            using Entry = std::pair<PemDigest, Key>;
+
+            mutable std::mutex mutex_;
+            std::list<Entry> entries_;
+            std::unordered_map<PemDigest, typename std::list<Entry>::iterator, PemDigestHash> index_;
+            size_t capacity_;
+            uint64_t hits_ = 0;
+            uint64_t misses_ = 0;
+            uint64_t evictions_ = 0;
+        };
+
+        constexpr size_t kDefaultKeyCacheCapacity = 16;
+
+        inline KeyCache<PublicKey>& publicKeyCache() {
+            static KeyCache<PublicKey> cache(kDefaultKeyCacheCapacity);
+            return cache;
         }
-        
-        throw std::runtime_error("unable to generate legacy-compatible RSA key pair");
-    }
-    
-    inline PemKeyPair generatePemKeyPair(int keyBits = 2048) {
-        ensureOpenSSLInit();
-        
-        if (keyBits < 512) {
-            throw std::invalid_argument("RSA key size must be at least 512 bits");
+
+        inline KeyCache<PrivateKey>& privateKeyCache() {
+            static KeyCache<PrivateKey> cache(kDefaultKeyCacheCapacity);
+            return cache;
         }
-        
-        detail::UniqueBN exponent(detail::makeBNFromWord(RSA_F4));
-        detail::UniqueRSA rsa(RSA_new());
-        if (!rsa) {
-            detail::throwOpenSSLError("failed to allocate RSA structure");
+
+        class LegacyCodebook;
+
+        inline KeyCache<std::shared_ptr<const LegacyCodebook>>& legacyCodebookCache() {
+            static KeyCache<std::shared_ptr<const LegacyCodebook>> cache(kDefaultKeyCacheCapacity);
+            return cache;
         }
-        
-        if (RSA_generate_key_ex(rsa.get(), keyBits, exponent.get(), nullptr) != 1) {
-            detail::throwOpenSSLError("RSA key generation failed");
+
+        inline PublicKey cachedPublicKey(const std::string& publicKeyPem) {
+            return publicKeyCache().getOrLoad(publicKeyPem);
+        }
+
+        inline PrivateKey cachedPrivateKey(const std::string& privateKeyPem) {
+            return privateKeyCache().getOrLoad(privateKeyPem);
+        }
+    } // namespace detail
+
+    // Sets how many parsed public and private keys (and legacy KeyPair codebooks) the string-based API
+    // keeps (each); 0 disables the cache.
+    inline void setKeyCacheCapacity(size_t capacity) {
+        detail::publicKeyCache().setCapacity(capacity);
+        detail::privateKeyCache().setCapacity(capacity);
+        detail::legacyCodebookCache().setCapacity(capacity);
+    }
+
+    inline void clearKeyCache() {
+        detail::publicKeyCache().clear();
+        detail::privateKeyCache().clear();
+        detail::legacyCodebookCache().clear();
+    }
+
+    inline KeyCacheStats keyCacheStats() {
+        KeyCacheStats stats;
+        detail::publicKeyCache().addStats(stats);
+        detail::privateKeyCache().addStats(stats);
+        detail::legacyCodebookCache().addStats(stats);
+        return stats;
+    }
+
+    struct ParallelConfig {
+        unsigned threadCount = 0;                 // Threads used per call, caller included; 0 = hardware concurrency
+        size_t minParallelBytes = 64 * 1024;      // Plaintext smaller than this is encrypted on the calling thread
+        size_t minParallelDecryptBytes = 2 * 1024; // Ciphertext threshold; private-key blocks are far costlier
+        int minParallelKeyBits = 2048;            // Two-prime keys this large search for primes on several threads
+    };
+
+    namespace detail {
+        // Persistent worker threads shared by the block-parallel paths.
+        class WorkerPool {
+        public:
+            explicit WorkerPool(unsigned workerCount) {
+                threads_.reserve(workerCount);
+                for (unsigned i = 0; i < workerCount; ++i) {
+                    threads_.emplace_back([this] { workerLoop(); });
+                }
+            }
+
+            ~WorkerPool() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stopping_ = true;
+                }
+                wake_.notify_all();
+                for (std::thread& thread : threads_) {
+                    thread.join();
+                }
+            }
+
+            WorkerPool(const WorkerPool&) = delete;
+            WorkerPool& operator=(const WorkerPool&) = delete;
+
+            // Runs body over [0, count) in ranges spread across the workers and the calling thread.
+            // Returns once every range has finished and rethrows the first exception raised by body.
+            void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+                if (count == 0) {
+                    return;
+                }
+                const size_t helpers = std::min(threads_.size(), count - 1);
+                if (helpers == 0 || onWorkerThread()) {
+                    body(0, count);
+                    return;
+                }
+
+                struct Job {
+                    const std::function<void(size_t, size_t)>* body = nullptr;
+                    size_t count = 0;
+                    size_t grain = 1;
+                    std::atomic<size_t> next{0};
+                    std::atomic<bool> failed{false};
+                    std::mutex mutex;
+                    std::condition_variable finished;
+                    size_t active = 0;
+                    bool closed = false;
+                    std::exception_ptr error;
+
+                    void run() {
+                        while (!failed.load(std::memory_order_relaxed)) {
+                            const size_t begin = next.fetch_add(grain);
+                            if (begin >= count) {
+                                break;
+                            }
+                            try {
+                                (*body)(begin, std::min(count, begin + grain));
+                            } catch (...) {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                if (!error) {
+                                    error = std::current_exception();
+                                }
+                                failed = true;
+                            }
+                        }
+                    }
+                };
+
+                auto job = std::make_shared<Job>();
+                job->body = &body;
+                job->count = count;
+                job->grain = std::max<size_t>(1, count / ((helpers + 1) * 8));
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (size_t i = 0; i < helpers; ++i) {
+                        tasks_.emplace_back([job] {
+                            {
+                                std::lock_guard<std::mutex> lock(job->mutex);
+                                if (job->closed) {
+                                    return;
+                                }
+                                ++job->active;
+                            }
+                            job->run();
+                            std::lock_guard<std::mutex> lock(job->mutex);
+                            if (--job->active == 0) {
+                                job->finished.notify_all();
+                            }
+                        });
+                    }
+                }
+                wake_.notify_all();
+
+                job->run();
+
+                // Helpers that have not started yet see the job closed and skip it, so the caller
+                // only waits for ranges that are actually in flight.
+                std::unique_lock<std::mutex> lock(job->mutex);
+                job->closed = true;
+                job->finished.wait(lock, [&] { return job->active == 0; });
+                if (job->error) {
+                    std::rethrow_exception(job->error);
+                }
+            }
+
+        private:
+            static bool& onWorkerThread() {
+                thread_local bool worker = false;
+                return worker;
+            }
+
+            void workerLoop() {
+                onWorkerThread() = true;
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                        if (tasks_.empty()) {
+                            return;
+                        }
+                        task = std::move(tasks_.front());
+                        tasks_.pop_front();
+                    }
+                    task();
+                }
+            }
+
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::deque<std::function<void()>> tasks_;
+            std::vector<std::thread> threads_;
+            bool stopping_ = false;
+        };
+
+        struct ParallelState {
+            std::mutex mutex;
+            ParallelConfig config;
+            std::shared_ptr<WorkerPool> pool;
+        };
+
+        inline ParallelState& parallelState() {
+            static ParallelState state;
+            return state;
+        }
+
+        inline unsigned effectiveThreadCount(const ParallelConfig& config) {
+            if (config.threadCount != 0) {
+                return config.threadCount;
+            }
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Returns the shared pool when an input of the given size should be split, nullptr otherwise.
+        inline std::shared_ptr<WorkerPool> workerPoolFor(KeyOperation operation, size_t inputBytes, size_t blocks) {
+            ParallelState& state = parallelState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            const unsigned threads = effectiveThreadCount(state.config);
+            const bool publicOperation = operation == KeyOperation::Encrypt || operation == KeyOperation::Verify;
+            const size_t threshold = publicOperation
+                ? state.config.minParallelBytes
+                : state.config.minParallelDecryptBytes;
+            // A fiber multiplexes work on its own thread; fanning out from one would block that thread.
+            if (threads <= 1 || blocks <= 1 || inputBytes < threshold || inFiber()) {
+                return nullptr;
+            }
+            if (!state.pool) {
+                state.pool = std::make_shared<WorkerPool>(threads - 1);
+            }
+            return state.pool;
+        }
+
+        // Returns the shared pool and the number of search lanes when key generation should run in parallel.
+        inline std::shared_ptr<WorkerPool> workerPoolForKeyGeneration(int keyBits, unsigned& lanes) {
+            ParallelState& state = parallelState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            lanes = effectiveThreadCount(state.config);
+            if (lanes <= 1 || keyBits < state.config.minParallelKeyBits || inFiber()) {
+                return nullptr;
+            }
+            if (!state.pool) {
+                state.pool = std::make_shared<WorkerPool>(lanes - 1);
+            }
+            return state.pool;
+        }
+    } // namespace detail
+
+    // Configures the block-parallel paths. The worker pool is rebuilt lazily after a thread count change.
+    inline void setParallelConfig(const ParallelConfig& config) {
+        std::shared_ptr<detail::WorkerPool> retired;
+        detail::ParallelState& state = detail::parallelState();
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (detail::effectiveThreadCount(config) != detail::effectiveThreadCount(state.config)) {
+                retired = std::move(state.pool);
+            }
+            state.config = config;
+        }
+    }
+
+    inline ParallelConfig parallelConfig() {
+        detail::ParallelState& state = detail::parallelState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.config;
+    }
+
+    enum class InitProfile {
+        Default,   // OpenSSL's regular initialisation, including openssl.cnf
+        FastStart  // No config file, default provider only, RSA/SHA prefetched, no atexit cleanup
+    };
+
+    struct InitReport {
+        InitProfile profile = InitProfile::Default;  // Profile in effect for this process
+        bool applied = false;                        // False if an earlier call already initialised OpenSSL
+        std::chrono::microseconds elapsed{0};        // Time spent in this call
+    };
+
+    namespace detail {
+        struct InitState {
+            std::once_flag once;
+            InitProfile profile = InitProfile::Default;
+        };
+
+        inline InitState& initState() {
+            static InitState state;
+            return state;
+        }
+    } // namespace detail
+
+    // Initialises OpenSSL once per process. FastStart must run before anything else touches OpenSSL,
+    // since the config file is only consulted by the first initialisation; one-shot tools that start
+    // thousands of times save the config parse, provider scan and exit-time cleanup. Later calls are
+    // no-ops that report the profile already in effect.
+    inline InitReport initializeOpenSSL(InitProfile profile = InitProfile::Default) {
+        const auto started = std::chrono::steady_clock::now();
+        detail::InitState& state = detail::initState();
+        InitReport report;
+        std::call_once(state.once, [&] {
+            uint64_t options = OPENSSL_INIT_LOAD_CRYPTO_STRINGS;
+            if (profile == InitProfile::FastStart) {
+                options |= OPENSSL_INIT_NO_LOAD_CONFIG;
+#ifdef OPENSSL_INIT_NO_ATEXIT
+                options |= OPENSSL_INIT_NO_ATEXIT;
+#endif
+            } else {
+                options |= OPENSSL_INIT_LOAD_CONFIG;
+            }
+            if (OPENSSL_init_crypto(options, nullptr) != 1) {
+                detail::throwOpenSSLError("OpenSSL initialisation failed");
+            }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            detail::LibraryContext& context = detail::libraryContextState();
+            if (profile == InitProfile::Default) {
+                context.prefetchExtended();
+            }
+#endif
+            state.profile = profile;
+            report.applied = true;
+        });
+        report.profile = state.profile;
+        report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        return report;
+    }
+
+    inline void ensureOpenSSLInit() {
+        static const bool initialized = (initializeOpenSSL(), true);
+        (void)initialized;
+    }
+    
+    // Shared flag for stopping long-running work from another thread. Copies observe the same flag.
+    class CancellationToken {
+    public:
+        CancellationToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+        void cancel() const noexcept { flag_->store(true, std::memory_order_release); }
+        bool cancelled() const noexcept { return flag_->load(std::memory_order_acquire); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> flag_;
+    };
+
+    // Thrown when an operation stops because its CancellationToken was cancelled.
+    class OperationCancelled : public std::runtime_error {
+    public:
+        OperationCancelled() : std::runtime_error("operation cancelled") {}
+    };
+
+    struct KeyGenProgress {
+        int primesFound = 0;
+        int primesNeeded = 2;
+        uint64_t candidatesTested = 0;  // Prime candidates examined so far, across all search threads
+    };
+
+    // Invoked from the generating thread or from worker threads, but never concurrently. A report
+    // may be skipped while an earlier call is still running; the final one is always delivered.
+    // An exception thrown from the callback aborts generation and is rethrown to the caller.
+    using KeyGenProgressCallback = std::function<void(const KeyGenProgress&)>;
+
+    namespace detail {
+        // Turns BN_GENCB events into KeyGenProgress reports and answers OpenSSL's "continue?"
+        // question from the cancellation token. The user's callback never runs under the counter
+        // lock, and an exception from it is held here rather than unwound through OpenSSL's C
+        // frames: the search is aborted and throwIfStopped() rethrows it once OpenSSL has returned.
+        class KeyGenMonitor {
+        public:
+            KeyGenMonitor(const KeyGenProgressCallback& callback, const CancellationToken& token, int primesNeeded)
+                : callback_(callback), token_(token) {
+                progress_.primesNeeded = primesNeeded;
+            }
+
+            bool cancelled() const noexcept { return token_.cancelled() || failed_.load(std::memory_order_acquire); }
+
+            void throwIfStopped() const {
+                if (failed_.load(std::memory_order_acquire)) {
+                    ERR_clear_error();
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    std::rethrow_exception(error_);
+                }
+                if (token_.cancelled()) {
+                    ERR_clear_error();
+                    throw OperationCancelled();
+                }
+            }
+
+            // Delivers the last report if a busy lane skipped it, then surfaces any callback error.
+            void finish() {
+                deliver(true);
+                throwIfStopped();
+            }
+
+            // BN_GENCB stage: 0 = new candidate, 3 = prime accepted by RSA key generation.
+            bool onEvent(int stage) {
+                if (stage == 0) {
+                    report([](KeyGenProgress& progress) { ++progress.candidatesTested; });
+                    fiberYield();
+                } else if (stage == 3) {
+                    primeFound();
+                }
+                return !cancelled();
+            }
+
+            void primeFound() {
+                report([](KeyGenProgress& progress) { ++progress.primesFound; });
+            }
+
+            void setCandidates(uint64_t candidates) {
+                report([candidates](KeyGenProgress& progress) { progress.candidatesTested = candidates; });
+            }
+
+            static int bnCallback(int stage, int, BN_GENCB* cb) {
+                return static_cast<KeyGenMonitor*>(BN_GENCB_get_arg(cb))->onEvent(stage) ? 1 : 0;
+            }
+
+        private:
+            template <typename Update>
+            void report(Update update) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    update(progress_);
+                    ++version_;
+                }
+                deliver(false);
+            }
+
+            // Hands the newest snapshot to the callback. Lanes that find another lane inside the
+            // callback skip their report instead of queueing behind it; finish() catches up.
+            void deliver(bool wait) noexcept {
+                if (!callback_) {
+                    return;
+                }
+                std::unique_lock<std::mutex> delivering(deliverMutex_, std::defer_lock);
+                if (wait) {
+                    delivering.lock();
+                } else if (!delivering.try_lock()) {
+                    return;
+                }
+                KeyGenProgress snapshot;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (delivered_ == version_ || failed_.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+                    delivered_ = version_;
+                    snapshot = progress_;
+                }
+                try {
+                    callback_(snapshot);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    error_ = std::current_exception();
+                    failed_.store(true, std::memory_order_release);
+                }
+            }
+
+            const KeyGenProgressCallback& callback_;
+            const CancellationToken& token_;
+            mutable std::mutex mutex_;
+            std::mutex deliverMutex_;
+            KeyGenProgress progress_;
+            uint64_t version_ = 0;
+            uint64_t delivered_ = 0;
+            std::exception_ptr error_;
+            std::atomic<bool> failed_{false};
+        };
+    } // namespace detail
+
+    // Legacy key generation with progress reports (one candidate per attempt) and cancellation
+    // checked between attempts.
+    inline KeyPair generateKeyPair(const KeyGenProgressCallback& progress, const CancellationToken& cancel) {
+        ensureOpenSSLInit();
+        
+        constexpr int kMaxAttempts = 32;
+        constexpr int kPrimeBits = 30; // ensures modulus fits into signed 64-bit range
+        
+        detail::UniqueBNCTX ctx(BN_CTX_new());
+        if (!ctx) {
+            detail::throwOpenSSLError("failed to create BN_CTX");
+        }
+        
+        detail::KeyGenMonitor monitor(progress, cancel, 2);
+        for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+            monitor.throwIfStopped();
+            monitor.setCandidates(static_cast<uint64_t>(attempt) + 1);
+            detail::UniqueBN p(BN_new());
+            detail::UniqueBN q(BN_new());
+            detail::UniqueBN n(BN_new());
+            detail::UniqueBN phi(BN_new());
+            detail::UniqueBN pMinus(BN_new());
+            detail::UniqueBN qMinus(BN_new());
+            detail::UniqueBN gcd(BN_new());
+            
+            if (!p || !q || !n || !phi || !pMinus || !qMinus || !gcd) {
+                detail::throwOpenSSLError("failed to allocate BIGNUM");
+            }
+            
+            if (BN_generate_prime_ex(p.get(), kPrimeBits, 0, nullptr, nullptr, nullptr) != 1) {
+                detail::throwOpenSSLError("failed to generate prime p");
+            }
+            if (BN_generate_prime_ex(q.get(), kPrimeBits, 0, nullptr, nullptr, nullptr) != 1) {
+                detail::throwOpenSSLError("failed to generate prime q");
+            }
+            if (BN_cmp(p.get(), q.get()) == 0) {
+                continue;
+            }
+            
+            if (BN_mul(n.get(), p.get(), q.get(), ctx.get()) != 1) {
+                detail::throwOpenSSLError("failed to compute modulus");
+            }
+            if (BN_num_bits(n.get()) > 63) {
+                continue;
+            }
+            
+            if (!BN_copy(pMinus.get(), p.get()) || BN_sub_word(pMinus.get(), 1) != 1) {
+                detail::throwOpenSSLError("failed to compute p-1");
+            }
+            if (!BN_copy(qMinus.get(), q.get()) || BN_sub_word(qMinus.get(), 1) != 1) {
+                detail::throwOpenSSLError("failed to compute q-1");
+            }
+            if (BN_mul(phi.get(), pMinus.get(), qMinus.get(), ctx.get()) != 1) {
+                detail::throwOpenSSLError("failed to compute phi");
+            }
+            
+            detail::UniqueBN e(detail::makeBNFromWord(65537));
+            if (BN_gcd(gcd.get(), e.get(), phi.get(), ctx.get()) != 1) {
+                detail::throwOpenSSLError("failed to compute gcd for exponent");
+            }
+            if (!BN_is_one(gcd.get())) {
+                static const unsigned long kFallbackExponents[] = {3UL, 5UL, 17UL, 257UL};
+                bool found = false;
+                for (unsigned long cand : kFallbackExponents) {
+                    if (BN_set_word(e.get(), cand) != 1) {
+                        detail::throwOpenSSLError("failed to set fallback exponent");
+                    }
+                    if (BN_gcd(gcd.get(), e.get(), phi.get(), ctx.get()) != 1) {
+                        detail::throwOpenSSLError("failed to compute gcd for fallback exponent");
+                    }
+                    if (BN_is_one(gcd.get())) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    continue;
+                }
+            }
+            
+            BIGNUM* rawD = BN_mod_inverse(nullptr, e.get(), phi.get(), ctx.get());
+            if (!rawD) {
+                detail::throwOpenSSLError("failed to compute private exponent");
+            }
+            detail::UniqueBN d(rawD);
+            
+            if (BN_num_bits(d.get()) > 63 || BN_num_bits(e.get()) > 32) {
+                continue;
+            }
+            
+            detail::UniqueOSSString nStr(BN_bn2dec(n.get()));
+            detail::UniqueOSSString dStr(BN_bn2dec(d.get()));
+            detail::UniqueOSSString eStr(BN_bn2dec(e.get()));
+            
+            if (!nStr || !dStr || !eStr) {
+                detail::throwOpenSSLError("failed to convert BIGNUM to string");
+            }
+            
+            monitor.primeFound();
+            monitor.primeFound();
+            monitor.finish();
+            return {std::string(eStr.get()), std::string(dStr.get()), std::string(nStr.get())};
+        }
+        
+        monitor.throwIfStopped();
+        throw std::runtime_error("unable to generate legacy-compatible RSA key pair");
+    }
+    
+    inline KeyPair generateKeyPair() {
+        return generateKeyPair(KeyGenProgressCallback(), CancellationToken());
+    }
+    
+    namespace detail {
+        // Shared state of a parallel two-prime search. Every lane hunts for a prime for the first
+        // open slot; the first acceptable candidate for each slot wins and the remaining searches
+        // are aborted from their BN_GENCB callback.
+        class PrimeSearch {
+        public:
+            PrimeSearch(int keyBits, KeyGenMonitor& monitor) : monitor_(monitor) {
+                bits_[0] = (keyBits + 1) / 2;
+                bits_[1] = keyBits - bits_[0];
+                // |p - q| must not be small enough for Fermat factoring.
+                minDistanceBits_ = std::max(bits_[1] - 100, 1);
+            }
+
+            bool done() const noexcept { return done_.load(std::memory_order_acquire); }
+            KeyGenMonitor& monitor() const noexcept { return monitor_; }
+
+            // False once every slot of this size is filled; lanes still searching for it give up.
+            bool wanted(int bits) const noexcept {
+                for (int slot = 0; slot < 2; ++slot) {
+                    if (bits_[slot] == bits && !filled_[slot].load(std::memory_order_acquire)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            void cancel() noexcept { done_.store(true, std::memory_order_release); }
+
+            // Size of the next prime worth searching for, or 0 when both slots are taken.
+            int nextBits() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (int slot = 0; slot < 2; ++slot) {
+                    if (!primes_[slot]) {
+                        return bits_[slot];
+                    }
+                }
+                return 0;
+            }
+
+            void offer(UniqueBN& candidate) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (int slot = 0; slot < 2; ++slot) {
+                    if (primes_[slot] || BN_num_bits(candidate.get()) != bits_[slot]) {
+                        continue;
+                    }
+                    const BIGNUM* other = primes_[1 - slot].get();
+                    if (other && !farEnough(candidate.get(), other)) {
+                        return;
+                    }
+                    primes_[slot] = std::move(candidate);
+                    filled_[slot].store(true, std::memory_order_release);
+                    monitor_.primeFound();
+                    if (primes_[0] && primes_[1]) {
+                        cancel();
+                    }
+                    return;
+                }
+            }
+
+            UniqueBN take(int slot) { return std::move(primes_[slot]); }
+
+        private:
+            bool farEnough(const BIGNUM* a, const BIGNUM* b) const {
+                UniqueBN diff(BN_new());
+                if (!diff || BN_sub(diff.get(), a, b) != 1) {
+                    throwOpenSSLError("failed to compare RSA primes");
+                }
+                return BN_num_bits(diff.get()) > minDistanceBits_;
+            }
+
+            KeyGenMonitor& monitor_;
+            std::atomic<bool> done_{false};
+            std::mutex mutex_;
+            int bits_[2] = {};
+            int minDistanceBits_ = 1;
+            UniqueBN primes_[2];
+            std::atomic<bool> filled_[2] = {};
+        };
+
+        // BN_GENCB argument: the shared search and the prime size this lane is looking for.
+        struct PrimeLane {
+            PrimeSearch* search;
+            int bits;
+        };
+
+        inline int primeSearchCallback(int stage, int, BN_GENCB* cb) {
+            PrimeLane* lane = static_cast<PrimeLane*>(BN_GENCB_get_arg(cb));
+            PrimeSearch* search = lane->search;
+            if (search->done() || !search->wanted(lane->bits)) {
+                return 0;
+            }
+            // Stage 3 is never raised by BN_generate_prime_ex; accepted primes are reported by offer().
+            if (!search->monitor().onEvent(stage)) {
+                search->cancel();
+                return 0;
+            }
+            return 1;
+        }
+
+        // Assembles a two-prime RSA key (n, d and CRT values) from p, q and e. This stands in for
+        // OpenSSL's own generator, so the result is held to the FIPS 186-4 bounds and checked by
+        // OpenSSL before it is returned.
+        inline UniqueEVPPKEY buildTwoPrimeKey(UniqueBN p, UniqueBN q, const BIGNUM* e) {
+            UniqueBNCTX ctx(BN_CTX_new());
+            UniqueBN n(BN_new()), d(BN_new()), dmp1(BN_new()), dmq1(BN_new()), iqmp(BN_new());
+            UniqueBN pMinus(BN_new()), qMinus(BN_new()), gcd(BN_new()), lambda(BN_new()), diff(BN_new());
+            UniqueBN publicExponent(BN_dup(e));
+            if (!ctx || !n || !d || !dmp1 || !dmq1 || !iqmp || !pMinus || !qMinus || !gcd || !lambda || !diff
+                || !publicExponent) {
+                throwOpenSSLError("failed to allocate RSA key components");
+            }
+            if (BN_cmp(p.get(), q.get()) < 0) {
+                std::swap(p, q);
+            }
+            BN_set_flags(p.get(), BN_FLG_CONSTTIME);
+            BN_set_flags(q.get(), BN_FLG_CONSTTIME);
+            BN_set_flags(lambda.get(), BN_FLG_CONSTTIME);
+            BN_set_flags(d.get(), BN_FLG_CONSTTIME);
+            // d = e^-1 mod lcm(p - 1, q - 1)
+            if (BN_mul(n.get(), p.get(), q.get(), ctx.get()) != 1
+                || BN_sub(diff.get(), p.get(), q.get()) != 1
+                || BN_sub(pMinus.get(), p.get(), BN_value_one()) != 1
+                || BN_sub(qMinus.get(), q.get(), BN_value_one()) != 1
+                || BN_gcd(gcd.get(), pMinus.get(), qMinus.get(), ctx.get()) != 1
+                || BN_mul(lambda.get(), pMinus.get(), qMinus.get(), ctx.get()) != 1
+                || BN_div(lambda.get(), nullptr, lambda.get(), gcd.get(), ctx.get()) != 1
+                || BN_mod_inverse(d.get(), publicExponent.get(), lambda.get(), ctx.get()) == nullptr
+                || BN_mod(dmp1.get(), d.get(), pMinus.get(), ctx.get()) != 1
+                || BN_mod(dmq1.get(), d.get(), qMinus.get(), ctx.get()) != 1
+                || BN_mod_inverse(iqmp.get(), q.get(), p.get(), ctx.get()) == nullptr) {
+                throwOpenSSLError("failed to derive RSA private key");
+            }
+            // |p - q| > 2^(nlen/2 - 100) and d > 2^(nlen/2).
+            const int halfBits = BN_num_bits(n.get()) / 2;
+            if (BN_num_bits(diff.get()) <= halfBits - 100 || BN_num_bits(d.get()) <= halfBits) {
+                throw std::runtime_error("RSA key generation failed: key is outside the FIPS 186-4 bounds");
+            }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            std::unique_ptr<OSSL_PARAM_BLD, decltype(&OSSL_PARAM_BLD_free)> builder(OSSL_PARAM_BLD_new(),
+                                                                                   &OSSL_PARAM_BLD_free);
+            if (!builder
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_N, n.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_E, publicExponent.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_D, d.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_FACTOR1, p.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_FACTOR2, q.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_EXPONENT1, dmp1.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_EXPONENT2, dmq1.get()) != 1
+                || OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_RSA_COEFFICIENT1, iqmp.get()) != 1) {
+                throwOpenSSLError("failed to collect RSA key parameters");
+            }
+            std::unique_ptr<OSSL_PARAM, decltype(&OSSL_PARAM_free)> params(OSSL_PARAM_BLD_to_param(builder.get()),
+                                                                         &OSSL_PARAM_free);
+            UniqueEVPPKEYCTX fromData(EVP_PKEY_CTX_new_from_name(libraryContext(), "RSA", nullptr));
+            EVP_PKEY* raw = nullptr;
+            if (!params || !fromData || EVP_PKEY_fromdata_init(fromData.get()) != 1
+                || EVP_PKEY_fromdata(fromData.get(), &raw, EVP_PKEY_KEYPAIR, params.get()) != 1) {
+                throwOpenSSLError("failed to build RSA key");
+            }
+            UniqueEVPPKEY pkey(raw);
+            UniqueEVPPKEYCTX check(EVP_PKEY_CTX_new_from_pkey(libraryContext(), pkey.get(), nullptr));
+            if (!check || EVP_PKEY_private_check(check.get()) != 1) {
+                throwOpenSSLError("RSA key generation failed: generated key did not validate");
+            }
+            // Pairwise consistency test as in FIPS 140 key generation: a random block must survive
+            // raw encryption and CRT decryption. (EVP_PKEY_pairwise_check would also re-run the
+            // primality tests the search already did, ~65 ms at 2048 bits.)
+            std::vector<unsigned char> block(static_cast<size_t>(BN_num_bytes(n.get()))), encrypted(block.size()),
+                decrypted(block.size());
+            size_t written = encrypted.size();
+            size_t recovered = decrypted.size();
+            UniqueEVPPKEYCTX encryptCtx(EVP_PKEY_CTX_new_from_pkey(libraryContext(), pkey.get(), nullptr));
+            UniqueEVPPKEYCTX decryptCtx(EVP_PKEY_CTX_new_from_pkey(libraryContext(), pkey.get(), nullptr));
+            if (RAND_bytes(block.data() + 1, static_cast<int>(block.size() - 1)) != 1
+                || !encryptCtx || !decryptCtx
+                || EVP_PKEY_encrypt_init(encryptCtx.get()) != 1
+                || EVP_PKEY_CTX_set_rsa_padding(encryptCtx.get(), RSA_NO_PADDING) != 1
+                || EVP_PKEY_encrypt(encryptCtx.get(), encrypted.data(), &written, block.data(), block.size()) != 1
+                || EVP_PKEY_decrypt_init(decryptCtx.get()) != 1
+                || EVP_PKEY_CTX_set_rsa_padding(decryptCtx.get(), RSA_NO_PADDING) != 1
+                || EVP_PKEY_decrypt(decryptCtx.get(), decrypted.data(), &recovered, encrypted.data(), written) != 1
+                || recovered != block.size() || decrypted != block) {
+                throwOpenSSLError("RSA key generation failed: generated key failed its pairwise test");
+            }
+            return pkey;
+#else
+            UniqueRSA rsa(RSA_new());
+            if (!rsa || RSA_set0_key(rsa.get(), n.get(), publicExponent.get(), d.get()) != 1) {
+                throwOpenSSLError("failed to set RSA key");
+            }
+            n.release();
+            publicExponent.release();
+            d.release();
+            if (RSA_set0_factors(rsa.get(), p.get(), q.get()) != 1) {
+                throwOpenSSLError("failed to set RSA factors");
+            }
+            p.release();
+            q.release();
+            if (RSA_set0_crt_params(rsa.get(), dmp1.get(), dmq1.get(), iqmp.get()) != 1) {
+                throwOpenSSLError("failed to set RSA CRT parameters");
+            }
+            dmp1.release();
+            dmq1.release();
+            iqmp.release();
+            if (RSA_check_key(rsa.get()) != 1) {
+                throwOpenSSLError("RSA key generation failed: generated key did not validate");
+            }
+            UniqueEVPPKEY pkey(EVP_PKEY_new());
+            if (!pkey || EVP_PKEY_assign_RSA(pkey.get(), rsa.get()) != 1) {
+                throwOpenSSLError("failed to wrap RSA key");
+            }
+            rsa.release();
+            return pkey;
+#endif
+        }
+
+        // Runs one prime search per lane on the shared pool. Since prime search time is roughly
+        // exponentially distributed, taking the first finishers cuts both the mean and the tail.
+        inline UniqueEVPPKEY generateTwoPrimeKeyParallel(int keyBits, const BIGNUM* e, WorkerPool& pool, unsigned lanes,
+                                                     KeyGenMonitor& monitor) {
+            PrimeSearch search(keyBits, monitor);
+            pool.parallelFor(lanes, [&](size_t, size_t) {
+                try {
+                    UniqueBNGENCB cb(BN_GENCB_new());
+                    UniqueBNCTX ctx(BN_CTX_new());
+                    UniqueBN pMinus(BN_new()), gcd(BN_new());
+                    if (!cb || !ctx || !pMinus || !gcd) {
+                        throwOpenSSLError("failed to allocate prime search state");
+                    }
+                    PrimeLane lane{&search, 0};
+                    BN_GENCB_set(cb.get(), &primeSearchCallback, &lane);
+                    while (!search.done()) {
+                        lane.bits = search.nextBits();
+                        if (lane.bits == 0) {
+                            break;
+                        }
+                        UniqueBN candidate(BN_new());
+                        if (!candidate) {
+                            throwOpenSSLError("failed to allocate BIGNUM");
+                        }
+                        if (BN_generate_prime_ex(candidate.get(), lane.bits, 0, nullptr, nullptr, cb.get()) != 1) {
+                            if (search.done()) {
+                                break;
+                            }
+                            if (!search.wanted(lane.bits)) {
+                                ERR_clear_error();
+                                continue;
+                            }
+                            throwOpenSSLError("prime generation failed");
+                        }
+                        // e must be invertible modulo p - 1.
+                        if (BN_sub(pMinus.get(), candidate.get(), BN_value_one()) != 1
+                            || BN_gcd(gcd.get(), pMinus.get(), e, ctx.get()) != 1) {
+                            throwOpenSSLError("failed to check prime candidate");
+                        }
+                        if (!BN_is_one(gcd.get())) {
+                            continue;
+                        }
+                        search.offer(candidate);
+                    }
+                } catch (...) {
+                    search.cancel();
+                    throw;
+                }
+            });
+            monitor.finish();
+            ERR_clear_error();
+            UniqueBN p = search.take(0);
+            UniqueBN q = search.take(1);
+            if (!p || !q) {
+                throw std::runtime_error("RSA key generation failed: prime search did not complete");
+            }
+            return buildTwoPrimeKey(std::move(p), std::move(q), e);
+        }
+    } // namespace detail
+    
+    // Largest prime count OpenSSL accepts for a modulus of the given size; more primes would make
+    // each factor small enough to weaken the key.
+    inline int maxPrimesForKeyBits(int keyBits) noexcept {
+        if (keyBits < 1024) {
+            return 2;
+        }
+        if (keyBits < 4096) {
+            return 3;
+        }
+        if (keyBits < 8192) {
+            return 4;
+        }
+        return 5;
+    }
+    
+    // primes > 2 produces a multi-prime (RFC 8017) key; CRT private operations then work on smaller
+    // factors and get faster. The PEM output loads through the same paths as a two-prime key.
+    // Generation with progress reports and cancellation; a cancelled token makes the prime search
+    // stop at its next candidate and throw OperationCancelled.
+    inline PemKeyPair generatePemKeyPair(int keyBits,
+                                         int primes,
+                                         const KeyGenProgressCallback& progress,
+                                         const CancellationToken& cancel) {
+        ensureOpenSSLInit();
+        
+        if (keyBits < 512) {
+            throw std::invalid_argument("RSA key size must be at least 512 bits");
+        }
+        if (primes < 2 || primes > maxPrimesForKeyBits(keyBits)) {
+            throw std::invalid_argument("a " + std::to_string(keyBits) + "-bit RSA key supports 2 to "
+                                        + std::to_string(maxPrimesForKeyBits(keyBits)) + " primes");
+        }
+        
+        detail::UniqueBN exponent(detail::makeBNFromWord(RSA_F4));
+        detail::KeyGenMonitor monitor(progress, cancel, primes);
+        monitor.throwIfStopped();
+        detail::UniqueRSA rsa;
+        detail::UniqueEVPPKEY assembled; // set by the parallel prime search instead of rsa
+        unsigned lanes = 1;
+        std::shared_ptr<detail::WorkerPool> pool;
+        if (primes == 2 && (pool = detail::workerPoolForKeyGeneration(keyBits, lanes))) {
+            assembled = detail::generateTwoPrimeKeyParallel(keyBits, exponent.get(), *pool, lanes, monitor);
+        } else {
+            rsa.reset(RSA_new());
+            detail::UniqueBNGENCB cb(BN_GENCB_new());
+            if (!rsa || !cb) {
+                detail::throwOpenSSLError("failed to allocate RSA structure");
+            }
+            BN_GENCB_set(cb.get(), &detail::KeyGenMonitor::bnCallback, &monitor);
+            const int generated = primes == 2
+                ? RSA_generate_key_ex(rsa.get(), keyBits, exponent.get(), cb.get())
+                : RSA_generate_multi_prime_key(rsa.get(), keyBits, primes, exponent.get(), cb.get());
+            if (generated != 1) {
+                monitor.throwIfStopped();
+                detail::throwOpenSSLError("RSA key generation failed");
+            }
+            monitor.finish();
+        }
+        
+        detail::UniqueBIO privateBio(BIO_new(BIO_s_mem()));
+        detail::UniqueBIO publicBio(BIO_new(BIO_s_mem()));
+        if (!privateBio || !publicBio) {
+            detail::throwOpenSSLError("failed to allocate BIO");
+        }
+        
+        // The traditional writer keeps the "RSA PRIVATE KEY" format of the RSA path.
+        if (assembled
+                ? PEM_write_bio_PrivateKey_traditional(privateBio.get(), assembled.get(), nullptr, nullptr, 0, nullptr, nullptr) != 1
+                : PEM_write_bio_RSAPrivateKey(privateBio.get(), rsa.get(), nullptr, nullptr, 0, nullptr, nullptr) != 1) {
+            detail::throwOpenSSLError("failed to write private key PEM");
+        }
+        
+        if (assembled
+                ? PEM_write_bio_PUBKEY(publicBio.get(), assembled.get()) != 1
+                : PEM_write_bio_RSA_PUBKEY(publicBio.get(), rsa.get()) != 1) {
+            detail::throwOpenSSLError("failed to write public key PEM");
+        }
+        
+        return {detail::bioToString(publicBio.get()), detail::bioToString(privateBio.get()), keyBits};
+    }
+    
+    inline PemKeyPair generatePemKeyPair(int keyBits = 2048, int primes = 2) {
+        return generatePemKeyPair(keyBits, primes, KeyGenProgressCallback(), CancellationToken());
+    }
+    
+    inline int getKeyBitsFromPublicKey(const std::string& publicKeyPem) {
+        return detail::cachedPublicKey(publicKeyPem).keyBits();
+    }
+    
+    struct KeyPoolOptions {
+        size_t capacity = 4;      // Ready key pairs kept per key size
+        size_t lowWaterMark = 2;  // A size is refilled up to capacity once fewer than this are ready
+        unsigned workers = 1;     // Background generator threads
+        int primes = 2;
+        std::string spoolPath;    // Unused keys are saved here on destruction and reloaded on construction
+    };
+
+    namespace detail {
+        constexpr const char* kKeyPoolSpoolHeader = "RSAUtil key pool v2";
+
+        // Pool queues are keyed on (key bits, prime count) so a multi-prime key never satisfies a
+        // request for a two-prime one.
+        using KeyPoolSlot = std::pair<int, int>;
+
+        inline std::string serializeKeyPool(const std::map<KeyPoolSlot, std::deque<PemKeyPair>>& keys) {
+            std::string text = std::string(kKeyPoolSpoolHeader) + "\n";
+            for (const auto& entry : keys) {
+                for (const PemKeyPair& pair : entry.second) {
+                    text += "keybits " + std::to_string(entry.first.first) + " primes " +
+                            std::to_string(entry.first.second) + "\n";
+                    text += pair.privateKeyPem;
+                    text += pair.publicKeyPem;
+                }
+            }
+            return text;
+        }
+
+        inline std::map<KeyPoolSlot, std::deque<PemKeyPair>> parseKeyPool(const std::string& text) {
+            std::map<KeyPoolSlot, std::deque<PemKeyPair>> keys;
+            std::istringstream input(text);
+            std::string line;
+            if (!std::getline(input, line) || line != kKeyPoolSpoolHeader) {
+                throw std::runtime_error("key pool spool has an unknown format");
+            }
+            auto readPem = [&input, &line]() {
+                std::string pem;
+                while (std::getline(input, line)) {
+                    pem += line;
+                    pem += '\n';
+                    if (line.rfind("-----END ", 0) == 0) {
+                        return pem;
+                    }
+                }
+                throw std::runtime_error("key pool spool is truncated");
+            };
+            while (std::getline(input, line)) {
+                if (line.empty()) {
+                    continue;
+                }
+                std::istringstream fields(line);
+                std::string keybitsTag;
+                std::string primesTag;
+                KeyPoolSlot slot;
+                if (!(fields >> keybitsTag >> slot.first >> primesTag >> slot.second) ||
+                    keybitsTag != "keybits" || primesTag != "primes") {
+                    throw std::runtime_error("key pool spool is malformed");
+                }
+                PemKeyPair pair;
+                pair.keyBits = slot.first;
+                pair.privateKeyPem = readPem();
+                pair.publicKeyPem = readPem();
+                keys[slot].push_back(std::move(pair));
+            }
+            return keys;
+        }
+
+        // A sibling of path that no other process or thread picks, for claim files.
+        inline std::string uniqueSiblingPath(const std::string& path, const char* tag) {
+            static std::atomic<unsigned long> counter{0};
+            unsigned char nonce[8] = {};
+            if (RAND_bytes(nonce, sizeof(nonce)) != 1) {
+                throwOpenSSLError("failed to generate a spool claim name");
+            }
+            static const char* hex = "0123456789abcdef";
+            std::string suffix;
+            for (unsigned char byte : nonce) {
+                suffix += hex[byte >> 4];
+                suffix += hex[byte & 0x0f];
+            }
+            return path + "." + tag + "." + std::to_string(counter.fetch_add(1)) + "." + suffix;
+        }
+
+        // Takes path away from every other reader by renaming it to a unique claim file, then returns
+        // its content and removes the claim. Only one concurrent caller can win the rename, so the
+        // content is handed to at most one process. Returns nullopt when path does not exist. On POSIX
+        // the file must be a regular file owned by the current user with mode 0600; anything else is
+        // put back and rejected.
+        inline std::optional<std::string> claimPrivateFile(const std::string& path) {
+            const std::string claim = uniqueSiblingPath(path, "claim");
+            std::error_code error;
+            std::filesystem::rename(path, claim, error);
+            if (error) {
+                if (error == std::errc::no_such_file_or_directory) {
+                    return std::nullopt;
+                }
+                throw std::runtime_error("failed to claim key pool spool: " + error.message());
+            }
+            std::string content;
+#if defined(_WIN32)
+            {
+                std::ifstream input(claim, std::ios::binary);
+                if (!input.is_open()) {
+                    throw std::runtime_error("failed to read key pool spool: " + claim);
+                }
+                content.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+            }
+#else
+            const int fd = ::open(claim.c_str(), O_RDONLY | O_NOFOLLOW);
+            struct stat info {};
+            if (fd < 0 || ::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_uid != ::geteuid() ||
+                (info.st_mode & 07777) != (S_IRUSR | S_IWUSR)) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                std::filesystem::rename(claim, path, error);
+                throw std::runtime_error("key pool spool must be a regular file owned by the current user with mode 0600: " + path);
+            }
+            char buffer[4096];
+            ssize_t result = 0;
+            while ((result = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                content.append(buffer, static_cast<size_t>(result));
+            }
+            ::close(fd);
+            if (result < 0) {
+                std::filesystem::rename(claim, path, error);
+                throw std::runtime_error("failed to read key pool spool: " + path);
+            }
+#endif
+            std::filesystem::remove(claim, error);
+            return content;
+        }
+
+        // Replaces path atomically with a file only the owner can read. On POSIX the temporary file
+        // comes from mkstemp, which creates it 0600 under a name no concurrent writer shares.
+        inline void writePrivateFile(const std::string& path, const std::string& content) {
+#if defined(_WIN32)
+            const std::string temporary = uniqueSiblingPath(path, "tmp");
+            {
+                std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+                if (!output || !output.write(content.data(), static_cast<std::streamsize>(content.size()))) {
+                    std::remove(temporary.c_str());
+                    throw std::runtime_error("failed to write key pool spool: " + temporary);
+                }
+            }
+#else
+            std::string pattern = path + ".XXXXXX";
+            const int fd = ::mkstemp(&pattern[0]);
+            if (fd < 0) {
+                throw std::runtime_error("failed to create key pool spool next to: " + path);
+            }
+            const std::string temporary = pattern;
+            ::fchmod(fd, S_IRUSR | S_IWUSR);
+            size_t written = 0;
+            while (written < content.size()) {
+                const ssize_t result = ::write(fd, content.data() + written, content.size() - written);
+                if (result <= 0) {
+                    ::close(fd);
+                    std::remove(temporary.c_str());
+                    throw std::runtime_error("failed to write key pool spool: " + temporary);
+                }
+                written += static_cast<size_t>(result);
+            }
+            ::fsync(fd);
+            ::close(fd);
+#endif
+            std::error_code error;
+            std::filesystem::rename(temporary, path, error);
+            if (error) {
+                std::remove(temporary.c_str());
+                throw std::runtime_error("failed to replace key pool spool: " + error.message());
+            }
+        }
+    } // namespace detail
+
+    // Keeps ready-made key pairs per key size so callers do not wait for prime generation. Background
+    // workers top a size back up to capacity once it drops below the low-water mark. A key is handed
+    // out at most once: the spool is claimed atomically when it is loaded and rewritten only on
+    // destruction. Queues are per (key size, options.primes), so pools with different prime counts
+    // can share a spool.
+    class KeyPool {
+    public:
+        explicit KeyPool(KeyPoolOptions options = {}) : options_(std::move(options)) {
+            if (options_.capacity == 0) {
+                throw std::invalid_argument("key pool capacity must be positive");
+            }
+            options_.lowWaterMark = std::min(options_.lowWaterMark, options_.capacity);
+            loadSpool();
+            const unsigned workers = std::max(1u, options_.workers);
+            workers_.reserve(workers);
+            for (unsigned i = 0; i < workers; ++i) {
+                workers_.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        ~KeyPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            // Abandon generations in flight instead of waiting for their prime search.
+            cancel_.cancel();
+            wake_.notify_all();
+            for (std::thread& worker : workers_) {
+                worker.join();
+            }
+            try {
+                saveSpool();
+            } catch (...) {
+                // Losing unused keys is safe; they are simply never handed out.
+            }
+        }
+
+        KeyPool(const KeyPool&) = delete;
+        KeyPool& operator=(const KeyPool&) = delete;
+
+        // Returns a ready key pair, or generates one on the calling thread if none is queued.
+        PemKeyPair acquire(int keyBits = 2048) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Queue& queue = queues_[slot(keyBits)];
+                if (!queue.ready.empty()) {
+                    PemKeyPair pair = std::move(queue.ready.front());
+                    queue.ready.pop_front();
+                    markForRefill(queue);
+                    return pair;
+                }
+                markForRefill(queue);
+            }
+            return generatePemKeyPair(keyBits, options_.primes);
+        }
+
+        // Starts keeping a queue of keyBits keys without taking one.
+        void prefill(int keyBits) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Queue& queue = queues_[slot(keyBits)];
+            if (queue.ready.size() < options_.capacity) {
+                queue.refilling = true;
+                wake_.notify_all();
+            }
+        }
+
+        // Blocks until capacity keyBits keys are ready. The destructor abandons refills in flight,
+        // so short-lived owners (a one-shot CLI run) call this to leave a stocked spool behind.
+        void fill(int keyBits) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            Queue& queue = queues_[slot(keyBits)];
+            if (queue.ready.size() < options_.capacity) {
+                queue.refilling = true;
+                wake_.notify_all();
+            }
+            stocked_.wait(lock, [&] { return queue.ready.size() >= options_.capacity || !queue.refilling; });
+            if (queue.ready.size() < options_.capacity) {
+                throw std::runtime_error("key pool refill failed");
+            }
+        }
+
+        size_t available(int keyBits) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = queues_.find(slot(keyBits));
+            return it == queues_.end() ? 0 : it->second.ready.size();
+        }
+
+    private:
+        struct Queue {
+            std::deque<PemKeyPair> ready;
+            size_t inFlight = 0;
+            bool refilling = false;
+        };
+
+        detail::KeyPoolSlot slot(int keyBits) const {
+            return {keyBits, options_.primes};
+        }
+
+        void markForRefill(Queue& queue) {
+            if (queue.ready.size() < options_.lowWaterMark) {
+                queue.refilling = true;
+                wake_.notify_all();
+            }
+        }
+
+        // Picks a size that still needs keys and reserves one generation slot for it.
+        bool claimWork(int& keyBits) {
+            for (auto& entry : queues_) {
+                Queue& queue = entry.second;
+                if (queue.refilling && queue.ready.size() + queue.inFlight < options_.capacity) {
+                    ++queue.inFlight;
+                    keyBits = entry.first.first;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void workerLoop() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                int keyBits = 0;
+                wake_.wait(lock, [&] { return stopping_ || claimWork(keyBits); });
+                if (stopping_ && keyBits == 0) {
+                    return;
+                }
+                lock.unlock();
+                PemKeyPair pair;
+                bool generated = false;
+                try {
+                    pair = generatePemKeyPair(keyBits, options_.primes, KeyGenProgressCallback(), cancel_);
+                    generated = true;
+                } catch (...) {
+                    // Leave the slot free; the next acquire() retries or reports the error itself.
+                }
+                lock.lock();
+                Queue& queue = queues_[slot(keyBits)];
+                --queue.inFlight;
+                if (generated) {
+                    queue.ready.push_back(std::move(pair));
+                } else {
+                    queue.refilling = false;
+                }
+                if (queue.ready.size() >= options_.capacity) {
+                    queue.refilling = false;
+                }
+                stocked_.notify_all();
+                if (stopping_) {
+                    return;
+                }
+            }
+        }
+
+        // Claims the whole spool, so two pools sharing one spool file never load the same key.
+        // Entries for other prime counts are kept in their own queues and saved back untouched.
+        void loadSpool() {
+            if (options_.spoolPath.empty()) {
+                return;
+            }
+            const std::optional<std::string> text = detail::claimPrivateFile(options_.spoolPath);
+            if (!text) {
+                return;
+            }
+            for (auto& entry : detail::parseKeyPool(*text)) {
+                Queue& queue = queues_[entry.first];
+                for (PemKeyPair& pair : entry.second) {
+                    queue.ready.push_back(std::move(pair));
+                }
+            }
+        }
+
+        // Merges in whatever another pool saved since this one loaded, then writes everything back.
+        // A pool that saves between the claim and the rename loses its keys, which is safe: they are
+        // dropped, never handed out twice.
+        void saveSpool() {
+            if (options_.spoolPath.empty()) {
+                return;
+            }
+            std::map<detail::KeyPoolSlot, std::deque<PemKeyPair>> keys;
+            for (auto& entry : queues_) {
+                if (!entry.second.ready.empty()) {
+                    keys[entry.first] = std::move(entry.second.ready);
+                }
+            }
+            if (const std::optional<std::string> text = detail::claimPrivateFile(options_.spoolPath)) {
+                for (auto& entry : detail::parseKeyPool(*text)) {
+                    std::deque<PemKeyPair>& merged = keys[entry.first];
+                    std::move(entry.second.begin(), entry.second.end(), std::back_inserter(merged));
+                }
+            }
+            if (keys.empty()) {
+                return;
+            }
+            detail::writePrivateFile(options_.spoolPath, detail::serializeKeyPool(keys));
+        }
+
+        KeyPoolOptions options_;
+        CancellationToken cancel_;
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable stocked_;
+        std::map<detail::KeyPoolSlot, Queue> queues_;
+        std::vector<std::thread> workers_;
+        bool stopping_ = false;
+    };
+
+    namespace detail {
+#if RSAUTIL_HAS_INT128
+        // Montgomery arithmetic modulo an odd n < 2^63 with R = 2^64, so a
+        // product plus m * n never overflows 128 bits and REDC needs one
+        // conditional subtraction.
+        class Montgomery64 {
+        public:
+            explicit Montgomery64(uint64_t modulus) : n_(modulus) {
+                uint64_t inverse = modulus; // correct to 3 bits for odd n
+                for (int i = 0; i < 5; ++i) {
+                    inverse *= 2 - modulus * inverse;
+                }
+                negInverse_ = 0 - inverse;
+                const uint64_t r = static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 64) % modulus);
+                r2_ = static_cast<uint64_t>(static_cast<unsigned __int128>(r) * r % modulus);
+            }
+
+            uint64_t pow(uint64_t base, uint64_t exponent) const {
+                uint64_t result = toMontgomery(1);
+                uint64_t power = toMontgomery(base);
+                while (exponent != 0) {
+                    if (exponent & 1) {
+                        result = multiply(result, power);
+                    }
+                    exponent >>= 1;
+                    if (exponent != 0) {
+                        power = multiply(power, power);
+                    }
+                }
+                return reduce(result);
+            }
+
+            // Raises independent bases to one shared exponent, kLanes at a time in
+            // lockstep over structure-of-arrays buffers: the lanes' multiplications
+            // do not depend on each other, so they overlap in the multiplier pipeline.
+            void powMany(const uint64_t* bases, uint64_t* out, size_t count, uint64_t exponent) const {
+                size_t i = 0;
+                for (; i + kLanes <= count; i += kLanes) {
+                    powLanes(bases + i, out + i, exponent);
+                }
+                for (; i < count; ++i) {
+                    out[i] = pow(bases[i], exponent);
+                }
+            }
+
+            static constexpr size_t kLanes = 8;
+
+        private:
+            void powLanes(const uint64_t* bases, uint64_t* out, uint64_t exponent) const {
+                uint64_t result[kLanes];
+                uint64_t power[kLanes];
+                const uint64_t one = toMontgomery(1);
+                for (size_t lane = 0; lane < kLanes; ++lane) {
+                    result[lane] = one;
+                    power[lane] = toMontgomery(bases[lane]);
+                }
+                while (exponent != 0) {
+                    if (exponent & 1) {
+                        for (size_t lane = 0; lane < kLanes; ++lane) {
+                            result[lane] = multiply(result[lane], power[lane]);
+                        }
+                    }
+                    exponent >>= 1;
+                    if (exponent != 0) {
+                        for (size_t lane = 0; lane < kLanes; ++lane) {
+                            power[lane] = multiply(power[lane], power[lane]);
+                        }
+                    }
+                }
+                for (size_t lane = 0; lane < kLanes; ++lane) {
+                    out[lane] = reduce(result[lane]);
+                }
+            }
+
+            uint64_t toMontgomery(uint64_t value) const { return multiply(value, r2_); }
+
+            uint64_t reduce(unsigned __int128 t) const {
+                const uint64_t m = static_cast<uint64_t>(t) * negInverse_;
+                const uint64_t u = static_cast<uint64_t>((t + static_cast<unsigned __int128>(m) * n_) >> 64);
+                return u >= n_ ? u - n_ : u;
+            }
+
+            uint64_t multiply(uint64_t a, uint64_t b) const {
+                return reduce(static_cast<unsigned __int128>(a) * b);
+            }
+
+            uint64_t n_;
+            uint64_t negInverse_;
+            uint64_t r2_;
+        };
+#endif
+
+        // One legacy key (exponent, modulus) parsed once for repeated modexps.
+        // Keys from generateKeyPair run natively; wider or unparsable keys, and
+        // compilers without __int128, go through BIGNUM.
+        class LegacyModExp {
+        public:
+            LegacyModExp(const std::string& exponent, const std::string& modulus) {
+#if RSAUTIL_HAS_INT128
+                if (parseWord(exponent, exponent_) && parseWord(modulus, modulus_) &&
+                    modulus_ > 1 && (modulus_ & 1) != 0 && modulus_ < (uint64_t(1) << 63)) {
+                    montgomery_.emplace(modulus_);
+                    return;
+                }
+#endif
+                modulusBN_ = makeBNFromDec(modulus);
+                exponentBN_ = makeBNFromDec(exponent);
+                valueBN_.reset(BN_new());
+                resultBN_.reset(BN_new());
+                ctx_.reset(BN_CTX_new());
+                if (!valueBN_ || !resultBN_ || !ctx_) {
+                    throwOpenSSLError("failed to initialise BIGNUM objects");
+                }
+            }
+
+            bool native() const {
+#if RSAUTIL_HAS_INT128
+                return montgomery_.has_value();
+#else
+                return false;
+#endif
+            }
+
+            // Returns false when value is not below the modulus.
+            bool accepts(uint64_t value) {
+#if RSAUTIL_HAS_INT128
+                if (montgomery_) {
+                    return value < modulus_;
+                }
+#endif
+                setValue(value);
+                return BN_cmp(valueBN_.get(), modulusBN_.get()) < 0;
+            }
+
+            // value^exponent mod modulus; value must satisfy accepts().
+            long long apply(uint64_t value, const char* failure) {
+#if RSAUTIL_HAS_INT128
+                if (montgomery_) {
+                    return static_cast<long long>(montgomery_->pow(value, exponent_));
+                }
+#endif
+                setValue(value);
+                if (BN_mod_exp(resultBN_.get(), valueBN_.get(), exponentBN_.get(), modulusBN_.get(), ctx_.get()) != 1) {
+                    throwOpenSSLError(failure);
+                }
+                return bnToLongLong(resultBN_.get());
+            }
+
+            // apply() over a whole buffer; every value must satisfy accepts().
+            void applyMany(const uint64_t* values, long long* out, size_t count, const char* failure) {
+#if RSAUTIL_HAS_INT128
+                if (montgomery_) {
+                    uint64_t chunk[kBatchChunk];
+                    for (size_t offset = 0; offset < count; offset += kBatchChunk) {
+                        const size_t n = std::min(kBatchChunk, count - offset);
+                        montgomery_->powMany(values + offset, chunk, n, exponent_);
+                        std::copy(chunk, chunk + n, out + offset);
+                    }
+                    return;
+                }
+#endif
+                for (size_t i = 0; i < count; ++i) {
+                    out[i] = apply(values[i], failure);
+                }
+            }
+
+            static constexpr size_t kBatchChunk = 256;
+
+        private:
+            static bool parseWord(const std::string& decimal, uint64_t& out) {
+                const char* end = decimal.data() + decimal.size();
+                const auto parsed = std::from_chars(decimal.data(), end, out);
+                return parsed.ec == std::errc() && parsed.ptr == end;
+            }
+
+            void setValue(uint64_t value) {
+                if (BN_set_word(valueBN_.get(), static_cast<unsigned long>(value)) != 1) {
+                    throwOpenSSLError("failed to set BIGNUM value");
+                }
+            }
+
+#if RSAUTIL_HAS_INT128
+            uint64_t exponent_ = 0;
+            uint64_t modulus_ = 0;
+            std::optional<Montgomery64> montgomery_;
+#endif
+            UniqueBN modulusBN_;
+            UniqueBN exponentBN_;
+            UniqueBN valueBN_;
+            UniqueBN resultBN_;
+            UniqueBNCTX ctx_;
+        };
+
+        // The 256 legacy ciphertexts of one KeyPair (byte-wise encryption is
+        // deterministic), with an open-addressing table for the reverse lookup.
+        class LegacyCodebook {
+        public:
+            // Null when the key cannot encrypt every byte value or any byte fails D(E(b)) == b.
+            static std::shared_ptr<const LegacyCodebook> build(const KeyPair& keyPair) {
+                auto book = std::make_shared<LegacyCodebook>();
+                try {
+                    LegacyModExp encryptor(keyPair.publicKey, keyPair.modulus);
+                    LegacyModExp decryptor(keyPair.privateKey, keyPair.modulus);
+                    if (!encryptor.accepts(255)) {
+                        return nullptr;
+                    }
+                    uint64_t values[256];
+                    for (uint64_t byte = 0; byte < 256; ++byte) {
+                        values[byte] = byte;
+                    }
+                    encryptor.applyMany(values, book->forward_.data(), 256, "RSA encryption failed");
+                    for (size_t byte = 0; byte < 256; ++byte) {
+                        values[byte] = static_cast<uint64_t>(book->forward_[byte]);
+                        if (!decryptor.accepts(values[byte])) {
+                            return nullptr;
+                        }
+                    }
+                    long long roundTrip[256];
+                    decryptor.applyMany(values, roundTrip, 256, "RSA decryption failed");
+                    for (size_t byte = 0; byte < 256; ++byte) {
+                        if (roundTrip[byte] != static_cast<long long>(byte)) {
+                            return nullptr;
+                        }
+                    }
+                } catch (const std::exception&) {
+                    return nullptr;
+                }
+
+                book->reverse_.fill(Slot{kEmpty, 0});
+                for (size_t byte = 0; byte < 256; ++byte) {
+                    size_t slot = slotFor(book->forward_[byte]);
+                    while (book->reverse_[slot].ciphertext != kEmpty) {
+                        slot = (slot + 1) & (kSlots - 1);
+                    }
+                    book->reverse_[slot] = Slot{book->forward_[byte], static_cast<uint8_t>(byte)};
+                }
+                return book;
+            }
+
+            long long encrypt(unsigned char byte) const {
+                return forward_[byte];
+            }
+
+            // The byte encrypting to `ciphertext`, or -1 when it is none of the 256.
+            int decrypt(long long ciphertext) const {
+                for (size_t slot = slotFor(ciphertext);; slot = (slot + 1) & (kSlots - 1)) {
+                    const Slot& entry = reverse_[slot];
+                    if (entry.ciphertext == kEmpty) {
+                        return -1;
+                    }
+                    if (entry.ciphertext == ciphertext) {
+                        return entry.byte;
+                    }
+                }
+            }
+
+        private:
+            struct Slot {
+                long long ciphertext;
+                uint8_t byte;
+            };
+
+            static constexpr size_t kSlots = 512; // load factor 1/2
+            static constexpr long long kEmpty = -1;
+
+            static size_t slotFor(long long ciphertext) {
+                return static_cast<size_t>((static_cast<uint64_t>(ciphertext) * 0x9E3779B97F4A7C15ULL) >> 55);
+            }
+
+            std::array<long long, 256> forward_{};
+            std::array<Slot, kSlots> reverse_{};
+        };
+
+        // Codebooks are cached per KeyPair, so repeated legacy jobs do no modexp after the first 256.
+        inline std::shared_ptr<const LegacyCodebook> legacyCodebook(const KeyPair& keyPair) {
+            return legacyCodebookCache().getOrLoad(
+                keyPair.publicKey + ':' + keyPair.privateKey + ':' + keyPair.modulus,
+                [&keyPair] { return LegacyCodebook::build(keyPair); });
+        }
+    }
+
+    inline long long encryptNumber(long long message, const std::string& publicKey, const std::string& modulus) {
+        ensureOpenSSLInit();
+        
+        if (message < 0) {
+            throw std::invalid_argument("message must be non-negative");
+        }
+        
+        detail::LegacyModExp engine(publicKey, modulus);
+        if (!engine.accepts(static_cast<uint64_t>(message))) {
+            throw std::runtime_error("message must be smaller than modulus");
+        }
+        return engine.apply(static_cast<uint64_t>(message), "RSA encryption failed");
+    }
+    
+    inline long long decryptNumber(long long ciphertext, const std::string& privateKey, const std::string& modulus) {
+        ensureOpenSSLInit();
+        
+        if (ciphertext < 0) {
+            throw std::invalid_argument("ciphertext must be non-negative");
+        }
+        
+        detail::LegacyModExp engine(privateKey, modulus);
+        if (!engine.accepts(static_cast<uint64_t>(ciphertext))) {
+            throw std::runtime_error("ciphertext must be smaller than modulus");
+        }
+        return engine.apply(static_cast<uint64_t>(ciphertext), "RSA decryption failed");
+    }
+    
+    // Paddings with a compile-time block geometry, see FixedEngine.
+    enum class Padding : int {
+        Pkcs1 = RSA_PKCS1_PADDING,
+        OaepSha1 = RSA_PKCS1_OAEP_PADDING,
+        None = RSA_NO_PADDING
+    };
+
+    namespace detail {
+        constexpr size_t paddingOverhead(Padding padding) {
+            return padding == Padding::Pkcs1 ? 11 : padding == Padding::OaepSha1 ? 42 : 0;
+        }
+
+        // Block and chunk sizes known at compile time: offsets fold to constants and the decrypt
+        // scratch block lives on the stack.
+        template <size_t BlockSize, size_t ChunkSize>
+        struct FixedGeometry {
+            static constexpr bool fixed = true;
+            static constexpr size_t blockSize = BlockSize;
+            static constexpr size_t chunkSize = ChunkSize;
+        };
+
+        struct RuntimeGeometry {
+            static constexpr bool fixed = false;
+            size_t blockSize;
+            size_t chunkSize;
+        };
+
+        template <int Bits, Padding Pad>
+        using GeometryFor = FixedGeometry<Bits / 8, Bits / 8 - paddingOverhead(Pad)>;
+
+        template <Padding Pad, typename Fn>
+        inline size_t withFixedBlock(size_t blockSize, Fn& fn) {
+            switch (blockSize) {
+                case 256:
+                    return fn(GeometryFor<2048, Pad>{});
+                case 384:
+                    return fn(GeometryFor<3072, Pad>{});
+                case 512:
+                    return fn(GeometryFor<4096, Pad>{});
+                default:
+                    return fn(RuntimeGeometry{blockSize, blockSize - paddingOverhead(Pad)});
+            }
+        }
+
+        // Calls fn with the compile-time geometry for 2048/3072/4096-bit keys and the common
+        // paddings, or with a runtime one otherwise. The padding must already be validated.
+        template <typename Fn>
+        inline size_t withGeometry(size_t blockSize, int padding, Fn&& fn) {
+            switch (padding) {
+                case RSA_PKCS1_OAEP_PADDING:
+                    return withFixedBlock<Padding::OaepSha1>(blockSize, fn);
+                case RSA_PKCS1_PADDING:
+                    return withFixedBlock<Padding::Pkcs1>(blockSize, fn);
+                case RSA_NO_PADDING:
+                    return withFixedBlock<Padding::None>(blockSize, fn);
+                default:
+                    return fn(RuntimeGeometry{blockSize,
+                                              static_cast<size_t>(maxChunkSizeForPadding(static_cast<int>(blockSize), padding))});
+            }
+        }
+
+        // Encrypts chunks [first, last) of the plaintext, each into its own blockSize output slot.
+        template <typename Geometry>
+        inline void encryptBlocks(const Geometry& geometry, EVP_PKEY_CTX* ctx,
+                                  const uint8_t* plaintext, size_t plaintextSize,
+                                  size_t first, size_t last, uint8_t* out) {
+            for (size_t block = first; block < last; ++block) {
+                const size_t offset = block * geometry.chunkSize;
+                const size_t chunkSize = std::min(geometry.chunkSize, plaintextSize - offset);
+                size_t written = geometry.blockSize;
+                if (EVP_PKEY_encrypt(ctx, out + block * geometry.blockSize, &written,
+                                     plaintext + offset, chunkSize) <= 0) {
+                    throwOpenSSLError("RSA public encrypt failed");
+                }
+                if (written != geometry.blockSize) {
+                    throw std::runtime_error("unexpected RSA ciphertext block length");
+                }
+                fiberYield();
+            }
+        }
+
+        // Serial decryption: straight into the output while a whole block still fits, otherwise
+        // through a scratch block (on the stack for fixed geometries, per-thread otherwise).
+        template <typename Geometry>
+        inline size_t decryptBlocks(const Geometry& geometry, EVP_PKEY_CTX* ctx,
+                                    const uint8_t* ciphertext, size_t blocks,
+                                    uint8_t* out, size_t outCapacity) {
+            auto run = [&](auto&& scratchBlock) {
+                size_t total = 0;
+                for (size_t block = 0; block < blocks; ++block) {
+                    const uint8_t* input = ciphertext + block * geometry.blockSize;
+                    size_t written = geometry.blockSize;
+                    if (outCapacity - total >= geometry.blockSize) {
+                        if (EVP_PKEY_decrypt(ctx, out + total, &written, input, geometry.blockSize) <= 0) {
+                            throwOpenSSLError("RSA private decrypt failed");
+                        }
+                    } else {
+                        uint8_t* scratch = scratchBlock();
+                        if (EVP_PKEY_decrypt(ctx, scratch, &written, input, geometry.blockSize) <= 0) {
+                            throwOpenSSLError("RSA private decrypt failed");
+                        }
+                        if (outCapacity - total < written) {
+                            throw std::invalid_argument("output buffer too small for RSA plaintext");
+                        }
+                        if (written != 0) {
+                            std::memcpy(out + total, scratch, written);
+                        }
+                    }
+                    total += written;
+                    fiberYield();
+                }
+                return total;
+            };
+
+            if constexpr (Geometry::fixed) {
+                std::array<uint8_t, Geometry::blockSize> scratch;
+                return run([&] { return scratch.data(); });
+            } else {
+                // Looked up per block: another fiber on this thread may have resized it meanwhile.
+                thread_local std::vector<uint8_t> scratch;
+                return run([&] {
+                    if (scratch.size() < geometry.blockSize) {
+                        scratch.resize(geometry.blockSize);
+                    }
+                    return scratch.data();
+                });
+            }
+        }
+    } // namespace detail
+
+    // Block geometry fixed at compile time for one key size and padding. Sizes are constexpr, so
+    // callers can size std::array buffers for them, and the serial loops carry no size lookups,
+    // padding switches or heap scratch. The key's size is checked once per call.
+    template <int Bits, Padding Pad>
+    class FixedEngine {
+        static_assert(Bits % 8 == 0 && Bits / 8 > static_cast<int>(detail::paddingOverhead(Pad)),
+                      "key size too small for this padding");
+
+    public:
+        using Geometry = detail::GeometryFor<Bits, Pad>;
+        using Block = std::array<uint8_t, Geometry::blockSize>;
+
+        static constexpr int keyBits = Bits;
+        static constexpr int padding = static_cast<int>(Pad);
+        static constexpr size_t blockSize = Geometry::blockSize;
+        static constexpr size_t chunkSize = Geometry::chunkSize;
+
+        static constexpr size_t encryptedSize(size_t plaintextSize) noexcept {
+            return (plaintextSize + chunkSize - 1) / chunkSize * blockSize;
+        }
+
+        static constexpr size_t maxDecryptedSize(size_t ciphertextSize) noexcept {
+            return ciphertextSize / blockSize * chunkSize;
+        }
+
+        // Padded Base64 (RFC 4648) length of a byte string, e.g. of one ciphertext block.
+        static constexpr size_t base64Size(size_t bytes) noexcept {
+            return (bytes + 2) / 3 * 4;
+        }
+
+        static constexpr size_t base64BlockSize = base64Size(blockSize);
+
+        static bool accepts(const PublicKey& publicKey) noexcept {
+            return static_cast<size_t>(publicKey.size()) == blockSize;
+        }
+
+        static bool accepts(const PrivateKey& privateKey) noexcept {
+            return static_cast<size_t>(privateKey.size()) == blockSize;
+        }
+
+        // Serial counterpart of RSAUtil::encryptInto() for keys of exactly Bits bits.
+        static size_t encryptInto(const uint8_t* plaintext, size_t plaintextSize,
+                                  const PublicKey& publicKey, uint8_t* out, size_t outCapacity) {
+            ensureOpenSSLInit();
+            const detail::KeyState& key = publicKey.state();
+            if (static_cast<size_t>(key.size()) != blockSize) {
+                throw std::invalid_argument("key size does not match FixedEngine");
+            }
+            const size_t required = encryptedSize(plaintextSize);
+            if (outCapacity < required) {
+                throw std::invalid_argument("output buffer too small for RSA ciphertext");
+            }
+            detail::KeyState::Lease ctx(key, detail::KeyOperation::Encrypt, padding);
+            detail::encryptBlocks(Geometry{}, ctx.get(), plaintext, plaintextSize, 0, required / blockSize, out);
+            return required;
+        }
+
+        // Serial counterpart of RSAUtil::decryptInto() for keys of exactly Bits bits.
+        static size_t decryptInto(const uint8_t* ciphertext, size_t ciphertextSize,
+                                  const PrivateKey& privateKey, uint8_t* out, size_t outCapacity) {
+            ensureOpenSSLInit();
+            const detail::KeyState& key = privateKey.state();
+            if (static_cast<size_t>(key.size()) != blockSize) {
+                throw std::invalid_argument("key size does not match FixedEngine");
+            }
+            if (ciphertextSize % blockSize != 0) {
+                throw std::invalid_argument("ciphertext length is not aligned with RSA block size");
+            }
+            detail::KeyState::Lease ctx(key, detail::KeyOperation::Decrypt, padding);
+            return detail::decryptBlocks(Geometry{}, ctx.get(), ciphertext, ciphertextSize / blockSize, out, outCapacity);
+        }
+    };
+
+    // Exact number of bytes encryptInto writes for a plaintext of the given size.
+    inline size_t encryptedSize(const PublicKey& publicKey,
+                                size_t plaintextSize,
+                                int padding = RSA_PKCS1_OAEP_PADDING) {
+        const int rsaSize = publicKey.state().size();
+        const int maxChunk = detail::maxChunkSizeForPadding(rsaSize, padding);
+        if (maxChunk <= 0) {
+            throw std::invalid_argument("padding configuration results in non-positive chunk size");
+        }
+        const size_t blocks = (plaintextSize + static_cast<size_t>(maxChunk) - 1) / static_cast<size_t>(maxChunk);
+        return blocks * static_cast<size_t>(rsaSize);
+    }
+    
+    // Upper bound on the bytes decryptInto writes; exact when every block carries a full chunk.
+    inline size_t maxDecryptedSize(const PrivateKey& privateKey,
+                                   size_t ciphertextSize,
+                                   int padding = RSA_PKCS1_OAEP_PADDING) {
+        const int rsaSize = privateKey.state().size();
+        const int maxChunk = detail::maxChunkSizeForPadding(rsaSize, padding);
+        if (maxChunk <= 0) {
+            throw std::invalid_argument("padding configuration results in non-positive chunk size");
+        }
+        return (ciphertextSize / static_cast<size_t>(rsaSize)) * static_cast<size_t>(maxChunk);
+    }
+    
+    // Encrypts into a caller-owned buffer of at least encryptedSize() bytes and returns the bytes written.
+    // Reusing the buffer and the key keeps the steady state free of heap allocations on our side.
+    inline size_t encryptInto(const uint8_t* plaintext,
+                              size_t plaintextSize,
+                              const PublicKey& publicKey,
+                              uint8_t* out,
+                              size_t outCapacity,
+                              int padding = RSA_PKCS1_OAEP_PADDING) {
+        ensureOpenSSLInit();
+        
+        const detail::KeyState& key = publicKey.state();
+        const size_t required = encryptedSize(publicKey, plaintextSize, padding);
+        if (outCapacity < required) {
+            throw std::invalid_argument("output buffer too small for RSA ciphertext");
+        }
+        if (plaintextSize == 0) {
+            return 0;
+        }
+        
+        // Every chunk encrypts to exactly one rsaSize block, so each chunk owns a fixed output slot
+        // and the chunks can be processed in any order.
+        return detail::withGeometry(static_cast<size_t>(key.size()), padding, [&](const auto& geometry) {
+            const size_t blocks = required / geometry.blockSize;
+            auto encryptRange = [&](size_t first, size_t last) {
+                detail::KeyState::Lease ctx(key, detail::KeyOperation::Encrypt, padding);
+                detail::encryptBlocks(geometry, ctx.get(), plaintext, plaintextSize, first, last, out);
+            };
+            if (std::shared_ptr<detail::WorkerPool> pool = detail::workerPoolFor(detail::KeyOperation::Encrypt, plaintextSize, blocks)) {
+                pool->parallelFor(blocks, encryptRange);
+            } else {
+                encryptRange(0, blocks);
+            }
+            return required;
+        });
+    }
+    
+    // Decrypts into a caller-owned buffer and returns the bytes written. A buffer of
+    // maxDecryptedSize() bytes is always large enough; one of ciphertextSize bytes also lets
+    // large inputs use the block-parallel path.
+    inline size_t decryptInto(const uint8_t* ciphertext,
+                              size_t ciphertextSize,
+                              const PrivateKey& privateKey,
+                              uint8_t* out,
+                              size_t outCapacity,
+                              int padding = RSA_PKCS1_OAEP_PADDING) {
+        ensureOpenSSLInit();
+        
+        const detail::KeyState& key = privateKey.state();
+        const size_t blockSize = static_cast<size_t>(key.size());
+        
+        if (ciphertextSize == 0) {
+            return 0;
+        }
+        
+        if (ciphertextSize % blockSize != 0) {
+            throw std::invalid_argument("ciphertext length is not aligned with RSA block size");
+        }
+        
+        const size_t blocks = ciphertextSize / blockSize;
+        
+        // Plaintext blocks are never longer than their ciphertext block, so with a ciphertext-sized
+        // buffer every block can be decrypted in place into its own slot and compacted afterwards.
+        if (outCapacity >= ciphertextSize) {
+            if (std::shared_ptr<detail::WorkerPool> pool = detail::workerPoolFor(detail::KeyOperation::Decrypt, ciphertextSize, blocks)) {
+                std::vector<size_t> lengths(blocks);
+                pool->parallelFor(blocks, [&](size_t first, size_t last) {
+                    detail::KeyState::Lease ctx(key, detail::KeyOperation::Decrypt, padding);
+                    for (size_t block = first; block < last; ++block) {
+                        size_t written = blockSize;
+                        if (EVP_PKEY_decrypt(ctx.get(), out + block * blockSize, &written,
+                                             ciphertext + block * blockSize, blockSize) <= 0) {
+                            detail::throwOpenSSLError("RSA private decrypt failed");
+                        }
+                        lengths[block] = written;
+                    }
+                });
+                
+                size_t total = 0;
+                for (size_t block = 0; block < blocks; ++block) {
+                    if (total != block * blockSize && lengths[block] != 0) {
+                        std::memmove(out + total, out + block * blockSize, lengths[block]);
+                    }
+                    total += lengths[block];
+                }
+                return total;
+            }
+        }
+        
+        detail::KeyState::Lease ctx(key, detail::KeyOperation::Decrypt, padding);
+        if (padding == RSA_PKCS1_PADDING || padding == RSA_PKCS1_OAEP_PADDING || padding == RSA_NO_PADDING) {
+            return detail::withGeometry(blockSize, padding, [&](const auto& geometry) {
+                return detail::decryptBlocks(geometry, ctx.get(), ciphertext, blocks, out, outCapacity);
+            });
+        }
+        // Other paddings have no chunk geometry of their own; decryption only needs the block size.
+        return detail::decryptBlocks(detail::RuntimeGeometry{blockSize, blockSize}, ctx.get(), ciphertext, blocks, out, outCapacity);
+    }
+    
+    inline std::vector<uint8_t> encryptBytes(const uint8_t* plaintext,
+                                            size_t plaintextSize,
+                                            const PublicKey& publicKey,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        std::vector<uint8_t> encrypted(encryptedSize(publicKey, plaintextSize, padding));
+        encryptInto(plaintext, plaintextSize, publicKey, encrypted.data(), encrypted.size(), padding);
+        return encrypted;
+    }
+    
+    inline std::vector<uint8_t> decryptBytes(const uint8_t* ciphertext,
+                                            size_t ciphertextSize,
+                                            const PrivateKey& privateKey,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        std::vector<uint8_t> decrypted(ciphertextSize);
+        decrypted.resize(decryptInto(ciphertext, ciphertextSize, privateKey, decrypted.data(), decrypted.size(), padding));
+        return decrypted;
+    }
+    
+    namespace detail {
+        template <typename String>
+        inline void decryptToStringImpl(const uint8_t* ciphertext,
+                                        size_t ciphertextSize,
+                                        const PrivateKey& privateKey,
+                                        String& out,
+                                        int padding) {
+            try {
+                out.resize(ciphertextSize);
+                out.resize(decryptInto(ciphertext, ciphertextSize, privateKey,
+                                       reinterpret_cast<uint8_t*>(out.data()), out.size(), padding));
+            } catch (...) {
+                out.clear();
+                throw;
+            }
+        }
+    } // namespace detail
+
+    // Decrypts straight into a std::string, reusing its capacity. out is cleared if decryption fails.
+    inline void decryptToString(const uint8_t* ciphertext,
+                                size_t ciphertextSize,
+                                const PrivateKey& privateKey,
+                                std::string& out,
+                                int padding = RSA_PKCS1_OAEP_PADDING) {
+        detail::decryptToStringImpl(ciphertext, ciphertextSize, privateKey, out, padding);
+    }
+    
+    inline std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& plaintext,
+                                            const PublicKey& publicKey,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptBytes(plaintext.data(), plaintext.size(), publicKey, padding);
+    }
+    
+    inline std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& ciphertext,
+                                            const PrivateKey& privateKey,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptBytes(ciphertext.data(), ciphertext.size(), privateKey, padding);
+    }
+    
+    inline std::vector<uint8_t> encryptBytes(const uint8_t* plaintext,
+                                            size_t plaintextSize,
+                                            const PemKeyPair& keyPair,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptBytes(plaintext, plaintextSize, detail::cachedPublicKey(keyPair.publicKeyPem), padding);
+    }
+    
+    inline std::vector<uint8_t> decryptBytes(const uint8_t* ciphertext,
+                                            size_t ciphertextSize,
+                                            const PemKeyPair& keyPair,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptBytes(ciphertext, ciphertextSize, detail::cachedPrivateKey(keyPair.privateKeyPem), padding);
+    }
+    
+    inline void decryptToString(const uint8_t* ciphertext,
+                                size_t ciphertextSize,
+                                const PemKeyPair& keyPair,
+                                std::string& out,
+                                int padding = RSA_PKCS1_OAEP_PADDING) {
+        decryptToString(ciphertext, ciphertextSize, detail::cachedPrivateKey(keyPair.privateKeyPem), out, padding);
+    }
+    
+    inline std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& plaintext,
+                                            const PemKeyPair& keyPair,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptBytes(plaintext.data(), plaintext.size(), keyPair, padding);
+    }
+    
+    inline std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& ciphertext,
+                                            const PemKeyPair& keyPair,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptBytes(ciphertext.data(), ciphertext.size(), keyPair, padding);
+    }
+    
+    // Text helpers accept any contiguous text (std::string, literals, file buffers) without copying it.
+    inline std::vector<uint8_t> encryptTextToBytes(std::string_view plaintext,
+                                                   const PublicKey& publicKey,
+                                                   int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptBytes(reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size(), publicKey, padding);
+    }
+    
+    inline std::string decryptTextFromBytes(const uint8_t* ciphertext,
+                                            size_t ciphertextSize,
+                                            const PrivateKey& privateKey,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        std::string plaintext;
+        decryptToString(ciphertext, ciphertextSize, privateKey, plaintext, padding);
+        return plaintext;
+    }
+    
+    inline std::string decryptTextFromBytes(const std::vector<uint8_t>& ciphertext,
+                                            const PrivateKey& privateKey,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptTextFromBytes(ciphertext.data(), ciphertext.size(), privateKey, padding);
+    }
+    
+    inline std::vector<uint8_t> encryptTextToBytes(std::string_view plaintext,
+                                                   const PemKeyPair& keyPair,
+                                                   int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptTextToBytes(plaintext, detail::cachedPublicKey(keyPair.publicKeyPem), padding);
+    }
+    
+    inline std::string decryptTextFromBytes(const uint8_t* ciphertext,
+                                            size_t ciphertextSize,
+                                            const PemKeyPair& keyPair,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptTextFromBytes(ciphertext, ciphertextSize, detail::cachedPrivateKey(keyPair.privateKeyPem), padding);
+    }
+    
+    inline std::string decryptTextFromBytes(const std::vector<uint8_t>& ciphertext,
+                                            const PemKeyPair& keyPair,
+                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptTextFromBytes(ciphertext.data(), ciphertext.size(), keyPair, padding);
+    }
+    
+    // Results of a batch call: item i occupies data[offsets[i], offsets[i + 1]).
+    struct ByteArena {
+        std::vector<uint8_t> data;
+        std::vector<size_t> offsets{0};
+
+        size_t size() const noexcept { return offsets.size() - 1; }
+        const uint8_t* item(size_t index) const noexcept { return data.data() + offsets[index]; }
+        size_t itemSize(size_t index) const noexcept { return offsets[index + 1] - offsets[index]; }
+        std::string_view view(size_t index) const noexcept {
+            return std::string_view(reinterpret_cast<const char*>(item(index)), itemSize(index));
+        }
+    };
+
+    namespace detail {
+        // Encrypts message after message into pre-sized slots. Messages are split across the worker
+        // pool and every range leases one context, so setup is paid per range rather than per message.
+        template <typename Messages>
+        inline ByteArena encryptManyImpl(const Messages& messages, size_t count, const PublicKey& publicKey, int padding) {
+            ensureOpenSSLInit();
+            const KeyState& key = publicKey.state();
+            const size_t blockSize = static_cast<size_t>(key.size());
+            const int maxChunk = maxChunkSizeForPadding(key.size(), padding);
+            if (maxChunk <= 0) {
+                throw std::invalid_argument("padding configuration results in non-positive chunk size");
+            }
+            const size_t chunk = static_cast<size_t>(maxChunk);
+
+            ByteArena arena;
+            arena.offsets.resize(count + 1);
+            size_t inputBytes = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const size_t length = messages(i).size();
+                inputBytes += length;
+                arena.offsets[i + 1] = arena.offsets[i] + (length + chunk - 1) / chunk * blockSize;
+            }
+            arena.data.resize(arena.offsets[count]);
+
+            auto encryptRange = [&](size_t first, size_t last) {
+                KeyState::Lease ctx(key, KeyOperation::Encrypt, padding);
+                for (size_t i = first; i < last; ++i) {
+                    const std::string_view message = messages(i);
+                    const uint8_t* input = reinterpret_cast<const uint8_t*>(message.data());
+                    uint8_t* out = arena.data.data() + arena.offsets[i];
+                    for (size_t offset = 0; offset < message.size(); offset += chunk, out += blockSize) {
+                        size_t written = blockSize;
+                        if (EVP_PKEY_encrypt(ctx.get(), out, &written, input + offset,
+                                             std::min(chunk, message.size() - offset)) <= 0) {
+                            throwOpenSSLError("RSA public encrypt failed");
+                        }
+                        if (written != blockSize) {
+                            throw std::runtime_error("unexpected RSA ciphertext block length");
+                        }
+                    }
+                }
+            };
+            if (std::shared_ptr<WorkerPool> pool = workerPoolFor(KeyOperation::Encrypt, inputBytes, count)) {
+                pool->parallelFor(count, encryptRange);
+            } else {
+                encryptRange(0, count);
+            }
+            return arena;
+        }
+
+        // Decrypts every message into a ciphertext-sized slot, then compacts the arena in place.
+        template <typename Messages>
+        inline ByteArena decryptManyImpl(const Messages& messages, size_t count, const PrivateKey& privateKey, int padding) {
+            ensureOpenSSLInit();
+            const KeyState& key = privateKey.state();
+            const size_t blockSize = static_cast<size_t>(key.size());
+
+            std::vector<size_t> slots(count + 1, 0);
+            for (size_t i = 0; i < count; ++i) {
+                const size_t length = messages(i).size();
+                if (length % blockSize != 0) {
+                    throw std::invalid_argument("ciphertext length is not aligned with RSA block size");
+                }
+                slots[i + 1] = slots[i] + length;
+            }
+
+            ByteArena arena;
+            arena.data.resize(slots[count]);
+            std::vector<size_t> lengths(count, 0);
+            auto decryptRange = [&](size_t first, size_t last) {
+                KeyState::Lease ctx(key, KeyOperation::Decrypt, padding);
+                for (size_t i = first; i < last; ++i) {
+                    const std::string_view message = messages(i);
+                    const uint8_t* input = reinterpret_cast<const uint8_t*>(message.data());
+                    uint8_t* out = arena.data.data() + slots[i];
+                    for (size_t offset = 0; offset < message.size(); offset += blockSize) {
+                        size_t written = blockSize;
+                        if (EVP_PKEY_decrypt(ctx.get(), out, &written, input + offset, blockSize) <= 0) {
+                            throwOpenSSLError("RSA private decrypt failed");
+                        }
+                        out += written;
+                        lengths[i] += written;
+                    }
+                }
+            };
+            if (std::shared_ptr<WorkerPool> pool = workerPoolFor(KeyOperation::Decrypt, slots[count], count)) {
+                pool->parallelFor(count, decryptRange);
+            } else {
+                decryptRange(0, count);
+            }
+
+            arena.offsets.resize(count + 1);
+            for (size_t i = 0; i < count; ++i) {
+                if (arena.offsets[i] != slots[i] && lengths[i] != 0) {
+                    std::memmove(arena.data.data() + arena.offsets[i], arena.data.data() + slots[i], lengths[i]);
+                }
+                arena.offsets[i + 1] = arena.offsets[i] + lengths[i];
+            }
+            arena.data.resize(arena.offsets[count]);
+            return arena;
+        }
+    } // namespace detail
+
+    // Batch entry points for many small independent messages under one key.
+    inline ByteArena encryptMany(const std::vector<std::string_view>& messages,
+                                 const PublicKey& publicKey,
+                                 int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::encryptManyImpl([&](size_t i) { return messages[i]; }, messages.size(), publicKey, padding);
+    }
+
+    inline ByteArena encryptMany(const ByteArena& messages,
+                                 const PublicKey& publicKey,
+                                 int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::encryptManyImpl([&](size_t i) { return messages.view(i); }, messages.size(), publicKey, padding);
+    }
+
+    inline ByteArena decryptMany(const ByteArena& ciphertexts,
+                                 const PrivateKey& privateKey,
+                                 int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::decryptManyImpl([&](size_t i) { return ciphertexts.view(i); }, ciphertexts.size(), privateKey, padding);
+    }
+
+    inline ByteArena decryptMany(const std::vector<std::string_view>& ciphertexts,
+                                 const PrivateKey& privateKey,
+                                 int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::decryptManyImpl([&](size_t i) { return ciphertexts[i]; }, ciphertexts.size(), privateKey, padding);
+    }
+
+    inline ByteArena encryptMany(const std::vector<std::string_view>& messages,
+                                 const PemKeyPair& keyPair,
+                                 int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptMany(messages, detail::cachedPublicKey(keyPair.publicKeyPem), padding);
+    }
+
+    inline ByteArena decryptMany(const ByteArena& ciphertexts,
+                                 const PemKeyPair& keyPair,
+                                 int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptMany(ciphertexts, detail::cachedPrivateKey(keyPair.privateKeyPem), padding);
+    }
+
+    namespace detail {
+        inline void checkSignaturePadding(int padding) {
+            if (padding != RSA_PKCS1_PSS_PADDING && padding != RSA_PKCS1_PADDING) {
+                throw std::invalid_argument("signatures support RSA_PKCS1_PSS_PADDING or RSA_PKCS1_PADDING only");
+            }
+        }
+
+        inline bool verifyWith(EVP_PKEY_CTX* ctx, const uint8_t* data, size_t size,
+                               const uint8_t* signature, size_t signatureSize) {
+            unsigned char digest[EVP_MAX_MD_SIZE];
+            const unsigned int digestSize = signatureHash(data, size, digest);
+            const int verified = EVP_PKEY_verify(ctx, signature, signatureSize, digest, digestSize);
+            if (verified != 1) {
+                // A bad signature leaves an error on the queue; it is an answer, not a failure.
+                ERR_clear_error();
+                return false;
+            }
+            return true;
+        }
+    } // namespace detail
+
+    // Signs SHA-256(data). padding is RSA_PKCS1_PSS_PADDING (salt length = digest length) or
+    // RSA_PKCS1_PADDING (PKCS#1 v1.5); the signature is always size() bytes.
+    inline std::vector<uint8_t> sign(const uint8_t* data,
+                                     size_t size,
+                                     const PrivateKey& privateKey,
+                                     int padding = RSA_PKCS1_PSS_PADDING) {
+        ensureOpenSSLInit();
+        detail::checkSignaturePadding(padding);
+        const detail::KeyState& key = privateKey.state();
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        const unsigned int digestSize = detail::signatureHash(data, size, digest);
+
+        std::vector<uint8_t> signature(static_cast<size_t>(key.size()));
+        size_t written = signature.size();
+        detail::KeyState::Lease ctx(key, detail::KeyOperation::Sign, padding);
+        if (EVP_PKEY_sign(ctx.get(), signature.data(), &written, digest, digestSize) != 1) {
+            detail::throwOpenSSLError("RSA sign failed");
+        }
+        signature.resize(written);
+        return signature;
+    }
+
+    inline std::vector<uint8_t> sign(const std::vector<uint8_t>& data,
+                                     const PrivateKey& privateKey,
+                                     int padding = RSA_PKCS1_PSS_PADDING) {
+        return sign(data.data(), data.size(), privateKey, padding);
+    }
+
+    inline std::vector<uint8_t> sign(const std::vector<uint8_t>& data,
+                                     const PemKeyPair& keyPair,
+                                     int padding = RSA_PKCS1_PSS_PADDING) {
+        return sign(data.data(), data.size(), detail::cachedPrivateKey(keyPair.privateKeyPem), padding);
+    }
+
+    // Returns false for a signature that does not match; throws only for unusable keys or arguments.
+    inline bool verify(const uint8_t* data,
+                       size_t size,
+                       const uint8_t* signature,
+                       size_t signatureSize,
+                       const PublicKey& publicKey,
+                       int padding = RSA_PKCS1_PSS_PADDING) {
+        ensureOpenSSLInit();
+        detail::checkSignaturePadding(padding);
+        detail::KeyState::Lease ctx(publicKey.state(), detail::KeyOperation::Verify, padding);
+        return detail::verifyWith(ctx.get(), data, size, signature, signatureSize);
+    }
+
+    inline bool verify(const std::vector<uint8_t>& data,
+                       const std::vector<uint8_t>& signature,
+                       const PublicKey& publicKey,
+                       int padding = RSA_PKCS1_PSS_PADDING) {
+        return verify(data.data(), data.size(), signature.data(), signature.size(), publicKey, padding);
+    }
+
+    inline bool verify(const std::vector<uint8_t>& data,
+                       const std::vector<uint8_t>& signature,
+                       const PemKeyPair& keyPair,
+                       int padding = RSA_PKCS1_PSS_PADDING) {
+        return verify(data.data(), data.size(), signature.data(), signature.size(),
+                      detail::cachedPublicKey(keyPair.publicKeyPem), padding);
+    }
+
+    // Verifies messages[i] against signatures[i] under one key. result[i] is 1 for a valid signature
+    // and 0 otherwise. Ranges run on the worker pool, each with one leased context.
+    inline std::vector<uint8_t> verifyMany(const std::vector<std::string_view>& messages,
+                                           const std::vector<std::string_view>& signatures,
+                                           const PublicKey& publicKey,
+                                           int padding = RSA_PKCS1_PSS_PADDING) {
+        ensureOpenSSLInit();
+        detail::checkSignaturePadding(padding);
+        if (messages.size() != signatures.size()) {
+            throw std::invalid_argument("verifyMany needs one signature per message");
+        }
+        const detail::KeyState& key = publicKey.state();
+        const size_t count = messages.size();
+        std::vector<uint8_t> result(count, 0);
+
+        size_t signatureBytes = 0;
+        for (const std::string_view signature : signatures) {
+            signatureBytes += signature.size();
+        }
+
+        auto verifyRange = [&](size_t first, size_t last) {
+            detail::KeyState::Lease ctx(key, detail::KeyOperation::Verify, padding);
+            for (size_t i = first; i < last; ++i) {
+                result[i] = detail::verifyWith(ctx.get(),
+                                               reinterpret_cast<const uint8_t*>(messages[i].data()), messages[i].size(),
+                                               reinterpret_cast<const uint8_t*>(signatures[i].data()), signatures[i].size())
+                    ? 1 : 0;
+            }
+        };
+        if (std::shared_ptr<detail::WorkerPool> pool = detail::workerPoolFor(detail::KeyOperation::Verify, signatureBytes, count)) {
+            pool->parallelFor(count, verifyRange);
+        } else {
+            verifyRange(0, count);
+        }
+        return result;
+    }
+
+    inline std::vector<uint8_t> verifyMany(const std::vector<std::string_view>& messages,
+                                           const std::vector<std::string_view>& signatures,
+                                           const PemKeyPair& keyPair,
+                                           int padding = RSA_PKCS1_PSS_PADDING) {
+        return verifyMany(messages, signatures, detail::cachedPublicKey(keyPair.publicKeyPem), padding);
+    }
+    
+    // Incremental encryption for inputs that do not fit in memory. update() encrypts every full
+    // plaintext chunk it can and keeps at most one partial chunk buffered; finish() flushes that
+    // remainder. The concatenated output is identical to encryptBytes() over the whole input.
+    class Encryptor {
+    public:
+        explicit Encryptor(PublicKey publicKey, int padding = RSA_PKCS1_OAEP_PADDING)
+            : key_(std::move(publicKey)), padding_(padding) {
+            const int rsaSize = key_.state().size();
+            const int maxChunk = detail::maxChunkSizeForPadding(rsaSize, padding_);
+            if (maxChunk <= 0) {
+                throw std::invalid_argument("padding configuration results in non-positive chunk size");
+            }
+            chunk_ = static_cast<size_t>(maxChunk);
+            blockSize_ = static_cast<size_t>(rsaSize);
+            pending_.resize(chunk_);
+        }
+        
+        explicit Encryptor(const PemKeyPair& keyPair, int padding = RSA_PKCS1_OAEP_PADDING)
+            : Encryptor(detail::cachedPublicKey(keyPair.publicKeyPem), padding) {}
+        
+        // Appends the ciphertext of every chunk completed by this input to out.
+        void update(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+            if (pendingSize_ > 0) {
+                const size_t take = std::min(size, chunk_ - pendingSize_);
+                if (take != 0) {
+                    std::memcpy(pending_.data() + pendingSize_, data, take);
+                }
+                pendingSize_ += take;
+                data += take;
+                size -= take;
+                if (pendingSize_ < chunk_) {
+                    return;
+                }
+                emit(pending_.data(), chunk_, out);
+                pendingSize_ = 0;
+            }
+            const size_t whole = size - size % chunk_;
+            if (whole != 0) {
+                emit(data, whole, out);
+            }
+            if (size != whole) {
+                std::memcpy(pending_.data(), data + whole, size - whole);
+            }
+            pendingSize_ = size - whole;
+        }
+        
+        std::vector<uint8_t> update(const std::vector<uint8_t>& data) {
+            std::vector<uint8_t> out;
+            update(data.data(), data.size(), out);
+            return out;
+        }
+        
+        // Appends the final block, if any, and resets the encryptor for a new stream.
+        void finish(std::vector<uint8_t>& out) {
+            const size_t remaining = pendingSize_;
+            pendingSize_ = 0;
+            if (remaining != 0) {
+                emit(pending_.data(), remaining, out);
+            }
+        }
+        
+        std::vector<uint8_t> finish() {
+            std::vector<uint8_t> out;
+            finish(out);
+            return out;
+        }
+        
+        // Plaintext bytes buffered until the next chunk completes.
+        size_t pending() const noexcept { return pendingSize_; }
+        
+    private:
+        void emit(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+            const size_t offset = out.size();
+            out.resize(offset + (size + chunk_ - 1) / chunk_ * blockSize_);
+            try {
+                encryptInto(data, size, key_, out.data() + offset, out.size() - offset, padding_);
+            } catch (...) {
+                out.resize(offset);
+                throw;
+            }
+        }
+        
+        PublicKey key_;
+        int padding_;
+        size_t chunk_ = 0;
+        size_t blockSize_ = 0;
+        std::vector<uint8_t> pending_;
+        size_t pendingSize_ = 0;
+    };
+    
+    // Incremental counterpart of decryptBytes(). Ciphertext may arrive split at any byte; only an
+    // incomplete block is held back between update() calls.
+    class Decryptor {
+    public:
+        explicit Decryptor(PrivateKey privateKey, int padding = RSA_PKCS1_OAEP_PADDING)
+            : key_(std::move(privateKey)), padding_(padding) {
+            blockSize_ = static_cast<size_t>(key_.state().size());
+            if (detail::maxChunkSizeForPadding(static_cast<int>(blockSize_), padding_) <= 0) {
+                throw std::invalid_argument("padding configuration results in non-positive chunk size");
+            }
+            pending_.resize(blockSize_);
+        }
+        
+        explicit Decryptor(const PemKeyPair& keyPair, int padding = RSA_PKCS1_OAEP_PADDING)
+            : Decryptor(detail::cachedPrivateKey(keyPair.privateKeyPem), padding) {}
+        
+        // Appends the plaintext of every block completed by this input to out.
+        void update(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+            if (pendingSize_ > 0) {
+                const size_t take = std::min(size, blockSize_ - pendingSize_);
+                if (take != 0) {
+                    std::memcpy(pending_.data() + pendingSize_, data, take);
+                }
+                pendingSize_ += take;
+                data += take;
+                size -= take;
+                if (pendingSize_ < blockSize_) {
+                    return;
+                }
+                emit(pending_.data(), blockSize_, out);
+                pendingSize_ = 0;
+            }
+            const size_t whole = size - size % blockSize_;
+            if (whole != 0) {
+                emit(data, whole, out);
+            }
+            if (size != whole) {
+                std::memcpy(pending_.data(), data + whole, size - whole);
+            }
+            pendingSize_ = size - whole;
+        }
+        
+        std::vector<uint8_t> update(const std::vector<uint8_t>& data) {
+            std::vector<uint8_t> out;
+            update(data.data(), data.size(), out);
+            return out;
+        }
+        
+        // Checks that the stream ended on a block boundary and resets the decryptor.
+        void finish() {
+            const size_t remaining = pendingSize_;
+            pendingSize_ = 0;
+            if (remaining != 0) {
+                throw std::invalid_argument("ciphertext length is not aligned with RSA block size");
+            }
+        }
+        
+        size_t pending() const noexcept { return pendingSize_; }
+        
+    private:
+        void emit(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+            // A ciphertext-sized window lets decryptInto use its block-parallel path.
+            const size_t offset = out.size();
+            out.resize(offset + size);
+            try {
+                out.resize(offset + decryptInto(data, size, key_, out.data() + offset, size, padding_));
+            } catch (...) {
+                out.resize(offset);
+                throw;
+            }
+        }
+        
+        PrivateKey key_;
+        int padding_;
+        size_t blockSize_ = 0;
+        std::vector<uint8_t> pending_;
+        size_t pendingSize_ = 0;
+    };
+    
+    // Hybrid envelope: a fresh AES-256-GCM data key is wrapped once with RSA-OAEP and the payload is
+    // encrypted symmetrically, so throughput no longer depends on the RSA block size. Layout:
+    //   "RSAH" | version (1) | wrapped key length (2, big endian) | wrapped key | IV (12) | ciphertext | tag (16)
+    // Everything before the ciphertext is authenticated as associated data.
+    namespace detail {
+        constexpr uint8_t kEnvelopeMagic[4] = {'R', 'S', 'A', 'H'};
+        constexpr uint8_t kEnvelopeVersion = 1;
+        constexpr size_t kEnvelopeKeySize = 32;
+        constexpr size_t kEnvelopeIvSize = 12;
+        constexpr size_t kEnvelopeTagSize = 16;
+        constexpr size_t kEnvelopePrefixSize = sizeof(kEnvelopeMagic) + 1 + 2;
+        // GCM limit for a single IV: 2^32 - 2 counter blocks.
+        constexpr uint64_t kEnvelopeMaxPayload = ((uint64_t{1} << 32) - 2) * 16;
+        // EVP_*Update takes an int length.
+        constexpr size_t kEnvelopeUpdateStep = size_t{1} << 30;
+        
+        inline const EVP_CIPHER* aes256Gcm() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            static EVP_CIPHER* cipher = [] {
+                EVP_CIPHER* fetched = EVP_CIPHER_fetch(libraryContext(), "AES-256-GCM", nullptr);
+                if (!fetched) {
+                    throwOpenSSLError("failed to fetch AES-256-GCM");
+                }
+                return fetched;
+            }();
+            return cipher;
+#else
+            return EVP_aes_256_gcm();
+#endif
+        }
+        
+        // Zeroes the data key on every exit path.
+        struct EnvelopeKey {
+            std::array<uint8_t, kEnvelopeKeySize> bytes{};
+            ~EnvelopeKey() { OPENSSL_cleanse(bytes.data(), bytes.size()); }
+        };
+        
+        inline void gcmUpdate(EVP_CIPHER_CTX* ctx, bool encrypt, const uint8_t* input, size_t size, uint8_t* out) {
+            for (size_t offset = 0; offset < size; offset += kEnvelopeUpdateStep) {
+                const int step = static_cast<int>(std::min(kEnvelopeUpdateStep, size - offset));
+                int written = 0;
+                const int ok = encrypt
+                    ? EVP_EncryptUpdate(ctx, out ? out + offset : nullptr, &written, input + offset, step)
+                    : EVP_DecryptUpdate(ctx, out ? out + offset : nullptr, &written, input + offset, step);
+                if (ok != 1 || written != step) {
+                    throwOpenSSLError("AES-256-GCM update failed");
+                }
+            }
+        }
+        
+        inline UniqueEVPCIPHERCTX makeGcmContext(bool encrypt, const EnvelopeKey& key, const uint8_t* iv) {
+            UniqueEVPCIPHERCTX ctx(EVP_CIPHER_CTX_new());
+            if (!ctx) {
+                throwOpenSSLError("failed to create EVP_CIPHER_CTX");
+            }
+            const int ok = encrypt
+                ? EVP_EncryptInit_ex(ctx.get(), aes256Gcm(), nullptr, key.bytes.data(), iv)
+                : EVP_DecryptInit_ex(ctx.get(), aes256Gcm(), nullptr, key.bytes.data(), iv);
+            if (ok != 1) {
+                throwOpenSSLError("failed to initialise AES-256-GCM");
+            }
+            return ctx;
+        }
+    } // namespace detail
+    
+    // Exact size of the envelope produced for a plaintext of the given size.
+    inline size_t hybridEncryptedSize(const PublicKey& publicKey, size_t plaintextSize) {
+        return detail::kEnvelopePrefixSize + static_cast<size_t>(publicKey.state().size())
+            + detail::kEnvelopeIvSize + plaintextSize + detail::kEnvelopeTagSize;
+    }
+    
+    namespace detail {
+        // Seals into envelope (resized to hybridEncryptedSize()), so callers choose the allocator.
+        template <typename Buffer>
+        inline void hybridEncryptInto(const uint8_t* plaintext,
+                                      size_t plaintextSize,
+                                      const PublicKey& publicKey,
+                                      Buffer& envelope) {
+            ensureOpenSSLInit();
+        
+            if (plaintextSize > kEnvelopeMaxPayload) {
+                throw std::invalid_argument("plaintext too large for a single AES-256-GCM envelope");
+            }
+            const size_t wrappedSize = static_cast<size_t>(publicKey.state().size());
+            if (wrappedSize > 0xFFFF) {
+                throw std::invalid_argument("RSA key too large for the envelope header");
+            }
+        
+            envelope.resize(hybridEncryptedSize(publicKey, plaintextSize));
+            uint8_t* const begin = reinterpret_cast<uint8_t*>(envelope.data());
+            uint8_t* cursor = begin;
+            std::memcpy(cursor, kEnvelopeMagic, sizeof(kEnvelopeMagic));
+            cursor += sizeof(kEnvelopeMagic);
+            *cursor++ = kEnvelopeVersion;
+            *cursor++ = static_cast<uint8_t>(wrappedSize >> 8);
+            *cursor++ = static_cast<uint8_t>(wrappedSize & 0xFF);
+        
+            EnvelopeKey key;
+            if (RAND_priv_bytes(key.bytes.data(), static_cast<int>(key.bytes.size())) != 1) {
+                throwOpenSSLError("failed to generate AES data key");
+            }
+            cursor += encryptInto(key.bytes.data(), key.bytes.size(), publicKey, cursor, wrappedSize,
+                                  RSA_PKCS1_OAEP_PADDING);
+        
+            uint8_t* iv = cursor;
+            if (RAND_bytes(iv, static_cast<int>(kEnvelopeIvSize)) != 1) {
+                throwOpenSSLError("failed to generate AES-GCM IV");
+            }
+            cursor += kEnvelopeIvSize;
+        
+            UniqueEVPCIPHERCTX ctx = makeGcmContext(true, key, iv);
+            gcmUpdate(ctx.get(), true, begin, static_cast<size_t>(cursor - begin), nullptr);
+            gcmUpdate(ctx.get(), true, plaintext, plaintextSize, cursor);
+            cursor += plaintextSize;
+            int finalLength = 0;
+            if (EVP_EncryptFinal_ex(ctx.get(), cursor, &finalLength) != 1 || finalLength != 0) {
+                throwOpenSSLError("AES-256-GCM finalisation failed");
+            }
+            if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, static_cast<int>(kEnvelopeTagSize), cursor) != 1) {
+                throwOpenSSLError("failed to read AES-256-GCM tag");
+            }
+        }
+    } // namespace detail
+
+    inline std::vector<uint8_t> hybridEncryptBytes(const uint8_t* plaintext,
+                                                   size_t plaintextSize,
+                                                   const PublicKey& publicKey) {
+        std::vector<uint8_t> envelope;
+        detail::hybridEncryptInto(plaintext, plaintextSize, publicKey, envelope);
+        return envelope;
+    }
+    
+    // Opens an envelope into out (resized to the plaintext). Throws and leaves out empty if the
+    // header, wrapped key or authentication tag do not check out.
+    template <typename Buffer>
+    inline void hybridDecryptInto(const uint8_t* envelope,
+                                  size_t envelopeSize,
+                                  const PrivateKey& privateKey,
+                                  Buffer& out) {
+        ensureOpenSSLInit();
+        out.clear();
+        
+        const size_t rsaSize = static_cast<size_t>(privateKey.state().size());
+        if (envelopeSize < detail::kEnvelopePrefixSize
+            || std::memcmp(envelope, detail::kEnvelopeMagic, sizeof(detail::kEnvelopeMagic)) != 0) {
+            throw std::invalid_argument("input is not a hybrid RSA envelope");
+        }
+        if (envelope[4] != detail::kEnvelopeVersion) {
+            throw std::invalid_argument("unsupported hybrid envelope version");
+        }
+        const size_t wrappedSize = (static_cast<size_t>(envelope[5]) << 8) | envelope[6];
+        if (wrappedSize != rsaSize) {
+            throw std::invalid_argument("hybrid envelope was wrapped for a different key size");
+        }
+        const size_t headerSize = detail::kEnvelopePrefixSize + wrappedSize + detail::kEnvelopeIvSize;
+        if (envelopeSize < headerSize + detail::kEnvelopeTagSize) {
+            throw std::invalid_argument("hybrid envelope is truncated");
+        }
+        const size_t payloadSize = envelopeSize - headerSize - detail::kEnvelopeTagSize;
+        
+        // The data key is unwrapped into out itself, which is about to be overwritten anyway, so
+        // opening an envelope allocates nothing beyond the plaintext buffer.
+        detail::EnvelopeKey key;
+        out.resize(std::max(rsaSize, payloadSize));
+        uint8_t* const unwrapped = reinterpret_cast<uint8_t*>(out.data());
+        size_t keySize = 0;
+        try {
+            keySize = decryptInto(envelope + detail::kEnvelopePrefixSize, wrappedSize, privateKey,
+                                  unwrapped, rsaSize, RSA_PKCS1_OAEP_PADDING);
+        } catch (...) {
+            out.clear();
+            throw;
+        }
+        if (keySize == key.bytes.size()) {
+            std::memcpy(key.bytes.data(), unwrapped, keySize);
+        }
+        OPENSSL_cleanse(unwrapped, rsaSize);
+        if (keySize != key.bytes.size()) {
+            out.clear();
+            throw std::runtime_error("hybrid envelope carries a malformed data key");
+        }
+        
+        const uint8_t* iv = envelope + detail::kEnvelopePrefixSize + wrappedSize;
+        try {
+            detail::UniqueEVPCIPHERCTX ctx = detail::makeGcmContext(false, key, iv);
+            out.resize(payloadSize);
+            detail::gcmUpdate(ctx.get(), false, envelope, headerSize, nullptr);
+            detail::gcmUpdate(ctx.get(), false, envelope + headerSize, payloadSize,
+                              reinterpret_cast<uint8_t*>(out.data()));
+            std::array<uint8_t, detail::kEnvelopeTagSize> tag{};
+            std::memcpy(tag.data(), envelope + headerSize + payloadSize, tag.size());
+            if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag.size()), tag.data()) != 1) {
+                detail::throwOpenSSLError("failed to set AES-256-GCM tag");
+            }
+            int finalLength = 0;
+            if (EVP_DecryptFinal_ex(ctx.get(), nullptr, &finalLength) != 1) {
+                ERR_clear_error();
+                throw std::runtime_error("hybrid envelope authentication failed");
+            }
+        } catch (...) {
+            if (!out.empty()) {
+                OPENSSL_cleanse(out.data(), out.size());
+            }
+            out.clear();
+            throw;
+        }
+    }
+    
+    inline std::vector<uint8_t> hybridDecryptBytes(const uint8_t* envelope,
+                                                   size_t envelopeSize,
+                                                   const PrivateKey& privateKey) {
+        std::vector<uint8_t> plaintext;
+        hybridDecryptInto(envelope, envelopeSize, privateKey, plaintext);
+        return plaintext;
+    }
+    
+    inline std::vector<uint8_t> hybridEncryptBytes(const std::vector<uint8_t>& plaintext, const PublicKey& publicKey) {
+        return hybridEncryptBytes(plaintext.data(), plaintext.size(), publicKey);
+    }
+    
+    inline std::vector<uint8_t> hybridDecryptBytes(const std::vector<uint8_t>& envelope, const PrivateKey& privateKey) {
+        return hybridDecryptBytes(envelope.data(), envelope.size(), privateKey);
+    }
+    
+    inline std::vector<uint8_t> hybridEncryptText(std::string_view plaintext, const PublicKey& publicKey) {
+        return hybridEncryptBytes(reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size(), publicKey);
+    }
+    
+    inline std::vector<uint8_t> hybridEncryptBytes(const std::vector<uint8_t>& plaintext, const PemKeyPair& keyPair) {
+        return hybridEncryptBytes(plaintext, detail::cachedPublicKey(keyPair.publicKeyPem));
+    }
+    
+    inline std::vector<uint8_t> hybridDecryptBytes(const std::vector<uint8_t>& envelope, const PemKeyPair& keyPair) {
+        return hybridDecryptBytes(envelope, detail::cachedPrivateKey(keyPair.privateKeyPem));
+    }
+    
+    inline std::vector<uint8_t> hybridEncryptText(std::string_view plaintext, const PemKeyPair& keyPair) {
+        return hybridEncryptText(plaintext, detail::cachedPublicKey(keyPair.publicKeyPem));
+    }
+    
+    inline void hybridDecryptToString(const uint8_t* envelope,
+                                      size_t envelopeSize,
+                                      const PemKeyPair& keyPair,
+                                      std::string& out) {
+        hybridDecryptInto(envelope, envelopeSize, detail::cachedPrivateKey(keyPair.privateKeyPem), out);
+    }
+    
+    struct AsyncConfig {
+        unsigned threadCount = 0;  // Executor threads; 0 = hardware concurrency
+        size_t maxInFlight = 64;   // Queued plus running operations; submitting beyond this blocks the caller
+    };
+
+    namespace detail {
+        // Executor behind the *Async functions, kept apart from the block-parallel WorkerPool so a
+        // long private-key or key generation job never occupies the threads that split large inputs.
+        class AsyncExecutor {
+        public:
+            AsyncExecutor(unsigned threadCount, size_t maxInFlight)
+                : maxInFlight_(std::max<size_t>(1, maxInFlight)) {
+                threads_.reserve(threadCount);
+                for (unsigned i = 0; i < threadCount; ++i) {
+                    threads_.emplace_back([this] { workerLoop(); });
+                }
+            }
+
+            // Runs what is already queued, then joins; futures handed out are always satisfied.
+            ~AsyncExecutor() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stopping_ = true;
+                }
+                work_.notify_all();
+                for (std::thread& thread : threads_) {
+                    thread.join();
+                }
+            }
+
+            AsyncExecutor(const AsyncExecutor&) = delete;
+            AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+            // Blocks while maxInFlight operations are pending. Submissions from inside a running
+            // task skip the wait, since blocking there could deadlock the executor.
+            void submit(std::function<void()> task) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!onExecutorThread()) {
+                    space_.wait(lock, [this] { return inFlight_ < maxInFlight_; });
+                }
+                ++inFlight_;
+                tasks_.push_back(std::move(task));
+                lock.unlock();
+                work_.notify_one();
+            }
+
+            size_t inFlight() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return inFlight_;
+            }
+
+        private:
+            static bool& onExecutorThread() {
+                thread_local bool executor = false;
+                return executor;
+            }
+
+            void workerLoop() {
+                onExecutorThread() = true;
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (true) {
+                    work_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                    if (tasks_.empty()) {
+                        return;
+                    }
+                    std::function<void()> task = std::move(tasks_.front());
+                    tasks_.pop_front();
+                    lock.unlock();
+                    task();
+                    task = nullptr;
+                    lock.lock();
+                    --inFlight_;
+                    space_.notify_one();
+                }
+            }
+
+            const size_t maxInFlight_;
+            mutable std::mutex mutex_;
+            std::condition_variable work_;
+            std::condition_variable space_;
+            std::deque<std::function<void()>> tasks_;
+            std::vector<std::thread> threads_;
+            size_t inFlight_ = 0;
+            bool stopping_ = false;
+        };
+
+        struct AsyncState {
+            std::mutex mutex;
+            AsyncConfig config;
+            std::shared_ptr<AsyncExecutor> executor;
+            // Executors replaced by setAsyncConfig. They are released once drained, and whatever is
+            // left is drained and joined here at exit, never by a detached thread.
+            std::vector<std::shared_ptr<AsyncExecutor>> retired;
+
+            AsyncState() = default;
+            AsyncState(const AsyncState&) = delete;
+            AsyncState& operator=(const AsyncState&) = delete;
+
+            ~AsyncState() {
+                retired.clear();
+                executor.reset();
+            }
+        };
+
+        // Moves the drained executors out of the retired list. An executor still running a task,
+        // such as the completion handler calling setAsyncConfig, is left for a later call, so no
+        // thread ever joins the executor it is running on.
+        inline std::vector<std::shared_ptr<AsyncExecutor>> takeDrainedExecutors(AsyncState& state) {
+            std::vector<std::shared_ptr<AsyncExecutor>> drained;
+            auto busy = std::partition(state.retired.begin(), state.retired.end(),
+                                       [](const std::shared_ptr<AsyncExecutor>& executor) { return executor->inFlight() != 0; });
+            std::move(busy, state.retired.end(), std::back_inserter(drained));
+            state.retired.erase(busy, state.retired.end());
+            return drained;
         }
-        
-        detail::UniqueBIO privateBio(BIO_new(BIO_s_mem()));
-        detail::UniqueBIO publicBio(BIO_new(BIO_s_mem()));
-        if (!privateBio || !publicBio) {
-            detail::throwOpenSSLError("failed to allocate BIO");
+
+        inline AsyncState& asyncState() {
+            static AsyncState state;
+            return state;
         }
-        
-        if (PEM_write_bio_RSAPrivateKey(privateBio.get(), rsa.get(), nullptr, nullptr, 0, nullptr, nullptr) != 1) {
-            detail::throwOpenSSLError("failed to write private key PEM");
+
+        inline std::shared_ptr<AsyncExecutor> asyncExecutor() {
+            AsyncState& state = asyncState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.executor) {
+                const unsigned threads = state.config.threadCount != 0
+                    ? state.config.threadCount
+                    : std::max(1u, std::thread::hardware_concurrency());
+                state.executor = std::make_shared<AsyncExecutor>(threads, state.config.maxInFlight);
+            }
+            return state.executor;
         }
-        
-        if (PEM_write_bio_RSA_PUBKEY(publicBio.get(), rsa.get()) != 1) {
-            detail::throwOpenSSLError("failed to write public key PEM");
+
+        template <typename Result>
+        inline std::future<Result> runAsync(std::function<Result()> work) {
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::move(work));
+            std::future<Result> future = task->get_future();
+            asyncExecutor()->submit([task] { (*task)(); });
+            return future;
         }
-        
-        return {detail::bioToString(publicBio.get()), detail::bioToString(privateBio.get()), keyBits};
+
+        template <typename Result>
+        inline void runAsync(std::function<Result()> work, std::function<void(Result, std::exception_ptr)> completion) {
+            asyncExecutor()->submit([work = std::move(work), completion = std::move(completion)] {
+                Result result{};
+                std::exception_ptr error;
+                try {
+                    result = work();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                try {
+                    completion(std::move(result), error);
+                } catch (...) {
+                    // Nobody is left to receive it; letting it out of the worker would terminate.
+                }
+            });
+        }
+    } // namespace detail
+
+    // Takes effect for the next submission; operations already queued finish on the old executor.
+    // Does not wait for them, so it may also be called from a completion handler. Old executors are
+    // joined by a later call once they are idle, or at exit.
+    inline void setAsyncConfig(const AsyncConfig& config) {
+        std::vector<std::shared_ptr<detail::AsyncExecutor>> drained;
+        detail::AsyncState& state = detail::asyncState();
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.executor) {
+                state.retired.push_back(std::move(state.executor));
+            }
+            state.config = config;
+            drained = detail::takeDrainedExecutors(state);
+        }
+        // drained goes out of scope here, outside the lock, joining those executors' idle workers. A
+        // submitter that grabbed one of them before the swap keeps it alive until its submit() returns.
     }
-    
-    inline int getKeyBitsFromPublicKey(const std::string& publicKeyPem) {
-        detail::UniqueRSA rsa(detail::loadPublicKey(publicKeyPem));
-        const int rsaSize = RSA_size(rsa.get());
-        if (rsaSize <= 0) {
-            throw std::runtime_error("invalid RSA key size");
+
+    inline AsyncConfig asyncConfig() {
+        detail::AsyncState& state = detail::asyncState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.config;
+    }
+
+    // Completion handlers run on an executor thread and receive either a result or the exception.
+    // Handlers should not throw; anything they throw is discarded.
+    using BytesCompletion = std::function<void(std::vector<uint8_t>, std::exception_ptr)>;
+
+    inline std::future<std::vector<uint8_t>> encryptAsync(std::vector<uint8_t> plaintext,
+                                                          PublicKey publicKey,
+                                                          int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::runAsync<std::vector<uint8_t>>(
+            [plaintext = std::move(plaintext), publicKey = std::move(publicKey), padding] {
+                return encryptBytes(plaintext, publicKey, padding);
+            });
+    }
+
+    inline std::future<std::vector<uint8_t>> decryptAsync(std::vector<uint8_t> ciphertext,
+                                                          PrivateKey privateKey,
+                                                          int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::runAsync<std::vector<uint8_t>>(
+            [ciphertext = std::move(ciphertext), privateKey = std::move(privateKey), padding] {
+                return decryptBytes(ciphertext, privateKey, padding);
+            });
+    }
+
+    inline void encryptAsync(std::vector<uint8_t> plaintext,
+                             PublicKey publicKey,
+                             BytesCompletion completion,
+                             int padding = RSA_PKCS1_OAEP_PADDING) {
+        detail::runAsync<std::vector<uint8_t>>(
+            [plaintext = std::move(plaintext), publicKey = std::move(publicKey), padding] {
+                return encryptBytes(plaintext, publicKey, padding);
+            },
+            std::move(completion));
+    }
+
+    inline void decryptAsync(std::vector<uint8_t> ciphertext,
+                             PrivateKey privateKey,
+                             BytesCompletion completion,
+                             int padding = RSA_PKCS1_OAEP_PADDING) {
+        detail::runAsync<std::vector<uint8_t>>(
+            [ciphertext = std::move(ciphertext), privateKey = std::move(privateKey), padding] {
+                return decryptBytes(ciphertext, privateKey, padding);
+            },
+            std::move(completion));
+    }
+
+    // PEM overloads parse (or look up) the key on the executor, not on the submitting thread.
+    inline std::future<std::vector<uint8_t>> encryptAsync(std::vector<uint8_t> plaintext,
+                                                          PemKeyPair keyPair,
+                                                          int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::runAsync<std::vector<uint8_t>>(
+            [plaintext = std::move(plaintext), keyPair = std::move(keyPair), padding] {
+                return encryptBytes(plaintext, keyPair, padding);
+            });
+    }
+
+    inline std::future<std::vector<uint8_t>> decryptAsync(std::vector<uint8_t> ciphertext,
+                                                          PemKeyPair keyPair,
+                                                          int padding = RSA_PKCS1_OAEP_PADDING) {
+        return detail::runAsync<std::vector<uint8_t>>(
+            [ciphertext = std::move(ciphertext), keyPair = std::move(keyPair), padding] {
+                return decryptBytes(ciphertext, keyPair, padding);
+            });
+    }
+
+    inline std::future<PemKeyPair> generateAsync(int keyBits = 2048,
+                                                 int primes = 2,
+                                                 KeyGenProgressCallback progress = KeyGenProgressCallback(),
+                                                 CancellationToken cancel = CancellationToken()) {
+        return detail::runAsync<PemKeyPair>(
+            [keyBits, primes, progress = std::move(progress), cancel = std::move(cancel)] {
+                return generatePemKeyPair(keyBits, primes, progress, cancel);
+            });
+    }
+
+    namespace detail {
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        // OpenSSL's default fiber stack is 32 KiB; key generation gets a larger one.
+        constexpr size_t kFiberStackSize = 256 * 1024;
+
+        inline void* allocateFiberStack(size_t* size) {
+            *size = kFiberStackSize;
+            return OPENSSL_malloc(kFiberStackSize);
+        }
+
+        inline void freeFiberStack(void* stack) {
+            OPENSSL_free(stack);
         }
-        return rsaSize * 8;
+
+        constexpr bool kFiberKeyGeneration = true;
+#else
+        // Fiber stacks are a fixed 32 KiB before OpenSSL 3.2, too tight to run prime generation on.
+        constexpr bool kFiberKeyGeneration = false;
+#endif
+
+        // This thread's OpenSSL fiber pool: sized by the first scheduler that runs a job here and
+        // released when the thread exits (ASYNC_start_job would otherwise create an unbounded one).
+        class FiberThreadPool {
+        public:
+            ~FiberThreadPool() {
+                if (initialized_) {
+                    ASYNC_cleanup_thread();
+                }
+            }
+
+            static bool ensure(size_t maxJobs) {
+                static std::once_flag stacks;
+                std::call_once(stacks, [] {
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+                    ASYNC_set_mem_functions(&allocateFiberStack, &freeFiberStack);
+#endif
+                });
+                thread_local FiberThreadPool pool;
+                if (!pool.initialized_) {
+                    pool.initialized_ = ASYNC_init_thread(maxJobs, 0) == 1;
+                }
+                return pool.initialized_;
+            }
+
+        private:
+            bool initialized_ = false;
+        };
     }
-    
-    inline long long encryptNumber(long long message, const std::string& publicKey, const std::string& modulus) {
-        ensureOpenSSLInit();
-        
-        if (message < 0) {
-            throw std::invalid_argument("message must be non-negative");
+
+    // Runs operations as OpenSSL ASYNC_JOB fibers on the calling thread. Each job yields between RSA
+    // blocks and between prime candidates, so one thread interleaves many encrypt/decrypt/keygen jobs
+    // without a thread (or a full stack switch through the kernel) per operation. Jobs only make
+    // progress inside poll()/run(), which must be called on the thread that owns the scheduler.
+    // Where the platform has no fiber support (ASYNC_is_capable() == 0) each job runs to completion
+    // on its first poll instead; so does key generation before OpenSSL 3.2 (see kFiberKeyGeneration).
+    class FiberScheduler {
+    public:
+        explicit FiberScheduler(size_t maxActiveJobs = 64)
+            : maxActive_(std::max<size_t>(1, maxActiveJobs)),
+              capable_(ASYNC_is_capable() != 0) {}
+
+        // Jobs still pending are finished, so no paused fiber outlives the scheduler.
+        ~FiberScheduler() {
+            try {
+                run();
+            } catch (...) {
+            }
         }
-        
-        detail::UniqueBN modulusBN(detail::makeBNFromDec(modulus));
-        detail::UniqueBN exponentBN(detail::makeBNFromDec(publicKey));
-        detail::UniqueBN messageBN(BN_new());
-        detail::UniqueBN resultBN(BN_new());
-        detail::UniqueBNCTX ctx(BN_CTX_new());
-        
-        if (!messageBN || !resultBN || !ctx) {
-            detail::throwOpenSSLError("failed to initialise BIGNUM objects");
+
+        FiberScheduler(const FiberScheduler&) = delete;
+        FiberScheduler& operator=(const FiberScheduler&) = delete;
+
+        static bool fibersAvailable() {
+            return ASYNC_is_capable() != 0;
         }
-        
-        if (BN_set_word(messageBN.get(), static_cast<unsigned long>(message)) != 1) {
-            detail::throwOpenSSLError("failed to set message BIGNUM");
+
+        std::future<std::vector<uint8_t>> encrypt(std::vector<uint8_t> plaintext,
+                                                  PublicKey publicKey,
+                                                  int padding = RSA_PKCS1_OAEP_PADDING) {
+            return submit<std::vector<uint8_t>>(
+                [plaintext = std::move(plaintext), publicKey = std::move(publicKey), padding] {
+                    return encryptBytes(plaintext, publicKey, padding);
+                });
         }
-        
-        if (BN_cmp(messageBN.get(), modulusBN.get()) >= 0) {
-            throw std::runtime_error("message must be smaller than modulus");
+
+        std::future<std::vector<uint8_t>> decrypt(std::vector<uint8_t> ciphertext,
+                                                  PrivateKey privateKey,
+                                                  int padding = RSA_PKCS1_OAEP_PADDING) {
+            return submit<std::vector<uint8_t>>(
+                [ciphertext = std::move(ciphertext), privateKey = std::move(privateKey), padding] {
+                    return decryptBytes(ciphertext, privateKey, padding);
+                });
         }
-        
-        if (BN_mod_exp(resultBN.get(), messageBN.get(), exponentBN.get(), modulusBN.get(), ctx.get()) != 1) {
-            detail::throwOpenSSLError("RSA encryption failed");
+
+        std::future<PemKeyPair> generate(int keyBits = 2048,
+                                         int primes = 2,
+                                         KeyGenProgressCallback progress = KeyGenProgressCallback(),
+                                         CancellationToken cancel = CancellationToken()) {
+            return submit<PemKeyPair>(
+                [keyBits, primes, progress = std::move(progress), cancel = std::move(cancel)] {
+                    return generatePemKeyPair(keyBits, primes, progress, cancel);
+                },
+                !detail::kFiberKeyGeneration);
         }
-        
-        return detail::bnToLongLong(resultBN.get());
-    }
-    
-    inline long long decryptNumber(long long ciphertext, const std::string& privateKey, const std::string& modulus) {
-        ensureOpenSSLInit();
-        
-        if (ciphertext < 0) {
-            throw std::invalid_argument("ciphertext must be non-negative");
+
+        // Starts queued jobs up to the active limit and resumes every active job once.
+        // Returns the number of jobs not yet finished.
+        size_t poll() {
+            while (active_.size() < maxActive_ && !queued_.empty()) {
+                active_.push_back(std::move(queued_.front()));
+                queued_.pop_front();
+            }
+
+            for (size_t i = 0; i < active_.size();) {
+                if (step(*active_[i])) {
+                    active_.erase(active_.begin() + static_cast<std::ptrdiff_t>(i));
+                } else {
+                    ++i;
+                }
+            }
+            return pending();
         }
-        
-        detail::UniqueBN modulusBN(detail::makeBNFromDec(modulus));
-        detail::UniqueBN exponentBN(detail::makeBNFromDec(privateKey));
-        detail::UniqueBN cipherBN(BN_new());
-        detail::UniqueBN resultBN(BN_new());
-        detail::UniqueBNCTX ctx(BN_CTX_new());
-        
-        if (!cipherBN || !resultBN || !ctx) {
-            detail::throwOpenSSLError("failed to initialise BIGNUM objects");
+
+        void run() {
+            while (poll() != 0) {
+            }
         }
-        
-        if (BN_set_word(cipherBN.get(), static_cast<unsigned long>(ciphertext)) != 1) {
-            detail::throwOpenSSLError("failed to set ciphertext BIGNUM");
+
+        size_t pending() const {
+            return active_.size() + queued_.size();
         }
-        
-        if (BN_cmp(cipherBN.get(), modulusBN.get()) >= 0) {
-            throw std::runtime_error("ciphertext must be smaller than modulus");
+
+    private:
+        struct Job {
+            std::function<void()> body;
+            std::function<void(std::exception_ptr)> fail;
+            ASYNC_JOB* fiber = nullptr;
+            detail::UniqueASYNCWAITCTX waitCtx;
+            bool runInline = false;
+        };
+
+        template <typename Result>
+        std::future<Result> submit(std::function<Result()> work, bool runInline = false) {
+            auto promise = std::make_shared<std::promise<Result>>();
+            std::future<Result> future = promise->get_future();
+
+            auto job = std::make_unique<Job>();
+            // Exceptions must not unwind across the fiber boundary; they are stored in the promise.
+            job->body = [promise, work = std::move(work)] {
+                try {
+                    promise->set_value(work());
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            };
+            job->fail = [promise](std::exception_ptr error) {
+                promise->set_exception(error);
+            };
+            job->runInline = runInline;
+            queued_.push_back(std::move(job));
+            return future;
         }
-        
-        if (BN_mod_exp(resultBN.get(), cipherBN.get(), exponentBN.get(), modulusBN.get(), ctx.get()) != 1) {
-            detail::throwOpenSSLError("RSA decryption failed");
+
+        static int fiberEntry(void* arg) {
+            Job* job = *static_cast<Job**>(arg);
+            job->body();
+            return 1;
         }
-        
-        return detail::bnToLongLong(resultBN.get());
-    }
+
+        // Returns true once the job has finished (successfully or not).
+        bool step(Job& job) {
+            if (!capable_ || job.runInline || !detail::FiberThreadPool::ensure(maxActive_)) {
+                job.body();
+                return true;
+            }
+            if (!job.waitCtx) {
+                job.waitCtx.reset(ASYNC_WAIT_CTX_new());
+                if (!job.waitCtx) {
+                    job.fail(std::make_exception_ptr(std::runtime_error("ASYNC_WAIT_CTX_new failed")));
+                    return true;
+                }
+            }
+
+            Job* arg = &job;
+            int ret = 0;
+            switch (ASYNC_start_job(&job.fiber, job.waitCtx.get(), &ret, &FiberScheduler::fiberEntry, &arg, sizeof(arg))) {
+                case ASYNC_PAUSE:
+                    return false;
+                case ASYNC_NO_JOBS:
+                    // The per-thread fiber pool is exhausted; try again on the next poll.
+                    return false;
+                case ASYNC_FINISH:
+                    return true;
+                default:
+                    job.fail(std::make_exception_ptr(std::runtime_error("ASYNC_start_job failed")));
+                    return true;
+            }
+        }
+
+        const size_t maxActive_;
+        const bool capable_;
+        std::deque<std::unique_ptr<Job>> queued_;
+        std::vector<std::unique_ptr<Job>> active_;
+    };
     
-    inline std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& plaintext,
-                                            const PemKeyPair& keyPair,
-                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+    inline std::vector<long long> encryptText(const std::string& plaintext, const KeyPair& keyPair) {
         ensureOpenSSLInit();
         
-        detail::UniqueRSA rsa(detail::loadPublicKey(keyPair.publicKeyPem));
-        const int rsaSize = RSA_size(rsa.get());
-        if (rsaSize <= 0) {
-            throw std::runtime_error("invalid RSA key size");
-        }
-        
-        const int maxChunk = detail::maxChunkSizeForPadding(rsaSize, padding);
-        if (maxChunk <= 0) {
-            throw std::invalid_argument("padding configuration results in non-positive chunk size");
-        }
+        std::vector<long long> ciphertext(plaintext.size());
         
-        std::vector<uint8_t> encrypted;
-        if (!plaintext.empty()) {
-            encrypted.reserve(((plaintext.size() + static_cast<size_t>(maxChunk) - 1) / static_cast<size_t>(maxChunk)) * static_cast<size_t>(rsaSize));
+        if (const std::shared_ptr<const detail::LegacyCodebook> book = detail::legacyCodebook(keyPair)) {
+            for (size_t i = 0; i < plaintext.size(); ++i) {
+                ciphertext[i] = book->encrypt(static_cast<unsigned char>(plaintext[i]));
+            }
+            return ciphertext;
         }
-        std::vector<uint8_t> buffer(static_cast<size_t>(rsaSize));
         
-        for (size_t offset = 0; offset < plaintext.size(); offset += static_cast<size_t>(maxChunk)) {
-            const size_t chunkSize = std::min(static_cast<size_t>(maxChunk), plaintext.size() - offset);
-            const int written = RSA_public_encrypt(static_cast<int>(chunkSize),
-                                                   plaintext.data() + offset,
-                                                   buffer.data(),
-                                                   rsa.get(),
-                                                   padding);
-            if (written <= 0) {
-                detail::throwOpenSSLError("RSA public encrypt failed");
+        detail::LegacyModExp engine(keyPair.publicKey, keyPair.modulus);
+        uint64_t values[detail::LegacyModExp::kBatchChunk];
+        for (size_t offset = 0; offset < plaintext.size(); offset += detail::LegacyModExp::kBatchChunk) {
+            const size_t count = std::min(detail::LegacyModExp::kBatchChunk, plaintext.size() - offset);
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = static_cast<unsigned char>(plaintext[offset + i]);
+                if (!engine.accepts(values[i])) {
+                    throw std::runtime_error("message must be smaller than modulus");
+                }
             }
-            encrypted.insert(encrypted.end(), buffer.begin(), buffer.begin() + written);
+            engine.applyMany(values, ciphertext.data() + offset, count, "RSA encryption failed");
         }
         
-        return encrypted;
+        return ciphertext;
     }
     
-    inline std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& ciphertext,
-                                            const PemKeyPair& keyPair,
-                                            int padding = RSA_PKCS1_OAEP_PADDING) {
+    inline std::string decryptText(const std::vector<long long>& ciphertext, const KeyPair& keyPair) {
         ensureOpenSSLInit();
         
-        detail::UniqueRSA rsa(detail::loadPrivateKey(keyPair.privateKeyPem));
-        const int rsaSize = RSA_size(rsa.get());
-        if (rsaSize <= 0) {
-            throw std::runtime_error("invalid RSA key size");
-        }
-        
-        if (ciphertext.empty()) {
-            return {};
-        }
+        std::string plaintext;
+        plaintext.reserve(ciphertext.size());
         
-        if (ciphertext.size() % static_cast<size_t>(rsaSize) != 0) {
-            throw std::invalid_argument("ciphertext length is not aligned with RSA block size");
+        if (const std::shared_ptr<const detail::LegacyCodebook> book = detail::legacyCodebook(keyPair)) {
+            for (long long value : ciphertext) {
+                int byte = book->decrypt(value);
+                if (byte < 0) {
+                    // Not a byte ciphertext: a real decrypt reports why.
+                    const long long decrypted = decryptNumber(value, keyPair.privateKey, keyPair.modulus);
+                    if (decrypted < 0 || decrypted > 255) {
+                        throw std::runtime_error("decrypted value is outside byte range");
+                    }
+                    byte = static_cast<int>(decrypted);
+                }
+                plaintext += static_cast<char>(byte);
+            }
+            return plaintext;
         }
         
-        std::vector<uint8_t> decrypted;
-        decrypted.reserve(ciphertext.size());
-        std::vector<uint8_t> buffer(static_cast<size_t>(rsaSize));
-        
-        for (size_t offset = 0; offset < ciphertext.size(); offset += static_cast<size_t>(rsaSize)) {
-            const int written = RSA_private_decrypt(rsaSize,
-                                                    ciphertext.data() + offset,
-                                                    buffer.data(),
-                                                    rsa.get(),
-                                                    padding);
-            if (written < 0) {
-                detail::throwOpenSSLError("RSA private decrypt failed");
+        detail::LegacyModExp engine(keyPair.privateKey, keyPair.modulus);
+        uint64_t values[detail::LegacyModExp::kBatchChunk];
+        long long decrypted[detail::LegacyModExp::kBatchChunk];
+        for (size_t offset = 0; offset < ciphertext.size(); offset += detail::LegacyModExp::kBatchChunk) {
+            const size_t count = std::min(detail::LegacyModExp::kBatchChunk, ciphertext.size() - offset);
+            for (size_t i = 0; i < count; ++i) {
+                const long long value = ciphertext[offset + i];
+                if (value < 0) {
+                    throw std::invalid_argument("ciphertext must be non-negative");
+                }
+                values[i] = static_cast<uint64_t>(value);
+                if (!engine.accepts(values[i])) {
+                    throw std::runtime_error("ciphertext must be smaller than modulus");
+                }
+            }
+            engine.applyMany(values, decrypted, count, "RSA decryption failed");
+            for (size_t i = 0; i < count; ++i) {
+                if (decrypted[i] < 0 || decrypted[i] > 255) {
+                    throw std::runtime_error("decrypted value is outside byte range");
+                }
+                plaintext += static_cast<char>(decrypted[i]);
             }
-            decrypted.insert(decrypted.end(), buffer.begin(), buffer.begin() + written);
         }
         
-        return decrypted;
+        return plaintext;
     }
     
-    inline std::vector<uint8_t> encryptTextToBytes(const std::string& plaintext,
-                                                   const PemKeyPair& keyPair,
-                                                   int padding = RSA_PKCS1_OAEP_PADDING) {
-        const std::vector<uint8_t> bytes(plaintext.begin(), plaintext.end());
-        return encryptBytes(bytes, keyPair, padding);
+    namespace detail {
+        // Plaintext bytes per packed legacy value: as many as stay below the
+        // modulus, at most 7 so every value fits a long long.
+        inline size_t legacyPackedWidth(const std::string& modulus) {
+            const int bits = BN_num_bits(makeBNFromDec(modulus).get());
+            return std::min<size_t>(bits > 0 ? static_cast<size_t>(bits - 1) / 8 : 0, 7);
+        }
     }
-    
-    inline std::string decryptTextFromBytes(const std::vector<uint8_t>& ciphertext,
-                                            const PemKeyPair& keyPair,
-                                            int padding = RSA_PKCS1_OAEP_PADDING) {
-        const std::vector<uint8_t> bytes = decryptBytes(ciphertext, keyPair, padding);
-        return std::string(bytes.begin(), bytes.end());
+
+    // Plaintext bytes each packed legacy value carries for this key; 0 when the modulus is too small.
+    inline size_t packedBytesPerValue(const KeyPair& keyPair) {
+        return detail::legacyPackedWidth(keyPair.modulus);
     }
-    
-    inline std::vector<long long> encryptText(const std::string& plaintext, const KeyPair& keyPair) {
-        std::vector<long long> ciphertext;
-        ciphertext.reserve(plaintext.size());
+
+    // Packed legacy format: E(plaintext length), then one value per
+    // legacyPackedWidth() plaintext bytes, big-endian, the last block zero-padded.
+    inline std::vector<long long> encryptTextPacked(const std::string& plaintext, const KeyPair& keyPair) {
+        ensureOpenSSLInit();
+        
+        const size_t width = detail::legacyPackedWidth(keyPair.modulus);
+        if (width == 0) {
+            throw std::runtime_error("modulus is too small for packed legacy mode");
+        }
+        if ((static_cast<uint64_t>(plaintext.size()) >> (8 * width)) != 0) {
+            throw std::runtime_error("plaintext is too long for packed legacy mode");
+        }
         
-        for (unsigned char c : plaintext) {
-            long long encrypted = encryptNumber(static_cast<long long>(c), keyPair.publicKey, keyPair.modulus);
-            ciphertext.push_back(encrypted);
+        const size_t blocks = (plaintext.size() + width - 1) / width;
+        std::vector<uint64_t> values(blocks + 1);
+        values[0] = plaintext.size();
+        for (size_t block = 0; block < blocks; ++block) {
+            uint64_t value = 0;
+            for (size_t i = 0, index = block * width; i < width; ++i, ++index) {
+                value = (value << 8) | (index < plaintext.size() ? static_cast<unsigned char>(plaintext[index]) : 0u);
+            }
+            values[block + 1] = value;
         }
         
+        std::vector<long long> ciphertext(values.size());
+        detail::LegacyModExp engine(keyPair.publicKey, keyPair.modulus);
+        engine.applyMany(values.data(), ciphertext.data(), values.size(), "RSA encryption failed");
         return ciphertext;
     }
     
-    inline std::string decryptText(const std::vector<long long>& ciphertext, const KeyPair& keyPair) {
-        std::string plaintext;
-        plaintext.reserve(ciphertext.size());
+    inline std::string decryptTextPacked(const std::vector<long long>& ciphertext, const KeyPair& keyPair) {
+        ensureOpenSSLInit();
+        
+        const size_t width = detail::legacyPackedWidth(keyPair.modulus);
+        if (width == 0) {
+            throw std::runtime_error("modulus is too small for packed legacy mode");
+        }
+        if (ciphertext.empty()) {
+            throw std::runtime_error("packed ciphertext is missing its length frame");
+        }
+        
+        detail::LegacyModExp engine(keyPair.privateKey, keyPair.modulus);
+        std::vector<uint64_t> values(ciphertext.size());
+        for (size_t i = 0; i < ciphertext.size(); ++i) {
+            if (ciphertext[i] < 0) {
+                throw std::invalid_argument("ciphertext must be non-negative");
+            }
+            values[i] = static_cast<uint64_t>(ciphertext[i]);
+            if (!engine.accepts(values[i])) {
+                throw std::runtime_error("ciphertext must be smaller than modulus");
+            }
+        }
+        std::vector<long long> decrypted(values.size());
+        engine.applyMany(values.data(), decrypted.data(), values.size(), "RSA decryption failed");
+        
+        const uint64_t limit = uint64_t(1) << (8 * width);
+        const uint64_t length = static_cast<uint64_t>(decrypted[0]);
+        if (length >= limit || (length + width - 1) / width != decrypted.size() - 1) {
+            throw std::runtime_error("packed ciphertext does not match its length frame");
+        }
         
-        for (long long value : ciphertext) {
-            long long decrypted = decryptNumber(value, keyPair.privateKey, keyPair.modulus);
-            if (decrypted < 0 || decrypted > 255) {
-                throw std::runtime_error("decrypted value is outside byte range");
+        std::string plaintext(static_cast<size_t>(length), '\0');
+        for (size_t block = 0; block + 1 < decrypted.size(); ++block) {
+            const uint64_t value = static_cast<uint64_t>(decrypted[block + 1]);
+            if (value >= limit) {
+                throw std::runtime_error("decrypted value is outside block range");
+            }
+            for (size_t i = 0, index = block * width; i < width; ++i, ++index) {
+                const char byte = static_cast<char>((value >> (8 * (width - 1 - i))) & 0xFF);
+                if (index < plaintext.size()) {
+                    plaintext[index] = byte;
+                } else if (byte != 0) {
+                    throw std::runtime_error("packed ciphertext does not match its length frame");
+                }
             }
-            plaintext += static_cast<char>(decrypted);
         }
         
         return plaintext;
@@ -529,4 +4140,122 @@ namespace RSAUtil {
         std::cout << "Private Key (d): " << keyPair.privateKey << std::endl;
         std::cout << "Modulus (n): " << keyPair.modulus << std::endl;
     }
+
+#if RSAUTIL_HAS_PMR
+    // Allocator-aware overloads: results come from the given memory_resource, e.g. a per-request
+    // std::pmr::monotonic_buffer_resource released in one step. Temporaries do not: the parallel
+    // decrypt path, key cache misses in the PemKeyPair overloads and growing per-thread scratch
+    // still allocate from the global heap.
+    inline std::pmr::vector<uint8_t> encryptBytes(const uint8_t* plaintext,
+                                                  size_t plaintextSize,
+                                                  const PublicKey& publicKey,
+                                                  std::pmr::memory_resource* resource,
+                                                  int padding = RSA_PKCS1_OAEP_PADDING) {
+        std::pmr::vector<uint8_t> encrypted(encryptedSize(publicKey, plaintextSize, padding), resource);
+        encryptInto(plaintext, plaintextSize, publicKey, encrypted.data(), encrypted.size(), padding);
+        return encrypted;
+    }
+
+    inline std::pmr::vector<uint8_t> decryptBytes(const uint8_t* ciphertext,
+                                                  size_t ciphertextSize,
+                                                  const PrivateKey& privateKey,
+                                                  std::pmr::memory_resource* resource,
+                                                  int padding = RSA_PKCS1_OAEP_PADDING) {
+        std::pmr::vector<uint8_t> decrypted(ciphertextSize, resource);
+        decrypted.resize(decryptInto(ciphertext, ciphertextSize, privateKey, decrypted.data(), decrypted.size(), padding));
+        return decrypted;
+    }
+
+    inline std::pmr::vector<uint8_t> encryptBytes(const uint8_t* plaintext,
+                                                  size_t plaintextSize,
+                                                  const PemKeyPair& keyPair,
+                                                  std::pmr::memory_resource* resource,
+                                                  int padding = RSA_PKCS1_OAEP_PADDING) {
+        return encryptBytes(plaintext, plaintextSize, detail::cachedPublicKey(keyPair.publicKeyPem), resource, padding);
+    }
+
+    inline std::pmr::vector<uint8_t> decryptBytes(const uint8_t* ciphertext,
+                                                  size_t ciphertextSize,
+                                                  const PemKeyPair& keyPair,
+                                                  std::pmr::memory_resource* resource,
+                                                  int padding = RSA_PKCS1_OAEP_PADDING) {
+        return decryptBytes(ciphertext, ciphertextSize, detail::cachedPrivateKey(keyPair.privateKeyPem), resource, padding);
+    }
+
+    // Decrypts into out, allocating from out's own resource.
+    inline void decryptToString(const uint8_t* ciphertext,
+                                size_t ciphertextSize,
+                                const PrivateKey& privateKey,
+                                std::pmr::string& out,
+                                int padding = RSA_PKCS1_OAEP_PADDING) {
+        detail::decryptToStringImpl(ciphertext, ciphertextSize, privateKey, out, padding);
+    }
+
+    inline std::pmr::vector<uint8_t> hybridEncryptBytes(const uint8_t* plaintext,
+                                                        size_t plaintextSize,
+                                                        const PublicKey& publicKey,
+                                                        std::pmr::memory_resource* resource) {
+        std::pmr::vector<uint8_t> envelope(resource);
+        detail::hybridEncryptInto(plaintext, plaintextSize, publicKey, envelope);
+        return envelope;
+    }
+
+    inline std::pmr::vector<uint8_t> hybridDecryptBytes(const uint8_t* envelope,
+                                                        size_t envelopeSize,
+                                                        const PrivateKey& privateKey,
+                                                        std::pmr::memory_resource* resource) {
+        std::pmr::vector<uint8_t> plaintext(resource);
+        hybridDecryptInto(envelope, envelopeSize, privateKey, plaintext);
+        return plaintext;
+    }
+
+    // Decimal text for the legacy ciphertext, formatted without per-value temporaries.
+    inline std::pmr::string ciphertextToString(const std::vector<long long>& ciphertext,
+                                               std::pmr::memory_resource* resource) {
+        std::pmr::string result(resource);
+        result.reserve(ciphertext.size() * 8);
+        char digits[24];
+        for (size_t i = 0; i < ciphertext.size(); ++i) {
+            if (i > 0) result += ',';
+            const std::to_chars_result written = std::to_chars(digits, digits + sizeof(digits), ciphertext[i]);
+            result.append(digits, written.ptr);
+        }
+        return result;
+    }
+
+    inline std::pmr::vector<long long> stringToCiphertext(std::string_view str,
+                                                          std::pmr::memory_resource* resource) {
+        std::pmr::vector<long long> result(resource);
+        size_t start = 0;
+        while (start <= str.size()) {
+            size_t end = str.find(',', start);
+            if (end == std::string_view::npos) {
+                end = str.size();
+            }
+            if (end > start) {
+                // Same acceptance as std::stoll in the std::string overload: leading whitespace and
+                // a '+' are skipped, anything after the digits is ignored.
+                const char* first = str.data() + start;
+                const char* last = str.data() + end;
+                while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+                    ++first;
+                }
+                if (first != last && *first == '+' && last - first > 1 && *(first + 1) != '-') {
+                    ++first;
+                }
+                long long value = 0;
+                const std::from_chars_result parsed = std::from_chars(first, last, value);
+                if (parsed.ec == std::errc::result_out_of_range) {
+                    throw std::out_of_range("ciphertext value out of range");
+                }
+                if (parsed.ec != std::errc()) {
+                    throw std::invalid_argument("invalid ciphertext value");
+                }
+                result.push_back(value);
+            }
+            start = end + 1;
+        }
+        return result;
+    }
+#endif
 }
@@ -6,11 +6,16 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cfloat>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 #include <filesystem>
@@ -64,12 +69,57 @@ Size=220,300
 #endif
 
 namespace {
+// Key generation running on the RSAUtil async executor. Replacing or destroying it cancels the
+// search, so abandoned work stops right away instead of burning a core.
+struct BackgroundKeyGen {
+    struct Progress {
+        RSAUtil::CancellationToken cancel;
+        std::atomic<int> primesFound{0};
+        std::atomic<int> primesNeeded{2};
+        std::atomic<uint64_t> candidatesTested{0};
+    };
+
+    std::shared_ptr<Progress> progress;
+    std::future<RSAUtil::PemKeyPair> result;
+
+    BackgroundKeyGen() = default;
+    BackgroundKeyGen(BackgroundKeyGen&&) = default;
+    BackgroundKeyGen& operator=(BackgroundKeyGen&& other) noexcept {
+        cancel();
+        progress = std::move(other.progress);
+        result = std::move(other.result);
+        return *this;
+    }
+    ~BackgroundKeyGen() { cancel(); }
+
+    bool running() const { return result.valid(); }
+    bool ready() const {
+        return result.valid() && result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    void cancel() {
+        if (progress) {
+            progress->cancel.cancel();
+        }
+    }
+
+    void start(int keyBits, int primes) {
+        auto shared = std::make_shared<Progress>();
+        shared->primesNeeded = primes;
+        result = RSAUtil::generateAsync(keyBits, primes, [shared](const RSAUtil::KeyGenProgress& update) {
+            shared->primesFound = update.primesFound;
+            shared->candidatesTested = update.candidatesTested;
+        }, shared->cancel);
+        progress = std::move(shared);
+    }
+};
+
 struct PemUiState {
     RSAUtil::PemKeyPair keyPair{};
     bool hasKey = false;
     bool hasPublicKey = false;
     bool hasPrivateKey = false;
     int keyBits = 2048;
+    int primes = 2;
     std::string publicKeyPem;
     std::string privateKeyPem;
     std::string publicKeyPath;
@@ -88,10 +138,12 @@ struct PemUiState {
     std::string encryptFileStatus;
     std::string decryptFileStatus;
     int paddingIndex = 0;
+    BackgroundKeyGen keyGen;
 };
 
-constexpr const char* kPaddingLabels[] = {"OAEP (SHA-1)", "PKCS#1 v1.5"};
-constexpr int kPaddingValues[] = {RSA_PKCS1_OAEP_PADDING, RSA_PKCS1_PADDING};
+constexpr const char* kPaddingLabels[] = {"OAEP (SHA-1)", "PKCS#1 v1.5", "Hybrid (RSA-OAEP + AES-256-GCM)"};
+constexpr int kPaddingValues[] = {RSA_PKCS1_OAEP_PADDING, RSA_PKCS1_PADDING, RSA_PKCS1_OAEP_PADDING};
+constexpr int kHybridPaddingIndex = 2;
 
 std::string encodeBase64(const std::vector<uint8_t>& data) {
     if (data.empty()) {
@@ -172,16 +224,40 @@ static void DrawPemKeyManagementTab(PemUiState& state) {
         keyBitsInput = std::clamp(keyBitsInput, 512, 16384);
         state.keyBits = keyBitsInput;
     }
-    if (ImGui::Button("Generate PEM key pair")) {
+    int primesInput = state.primes;
+    if (ImGui::InputInt("Primes", &primesInput)) {
+        state.primes = std::clamp(primesInput, 2, 5);
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(max %d at this size)", RSAUtil::maxPrimesForKeyBits(state.keyBits));
+    if (state.keyGen.ready()) {
         try {
-            state.keyPair = RSAUtil::generatePemKeyPair(state.keyBits);
+            state.keyPair = state.keyGen.result.get();
             state.publicKeyPem = state.keyPair.publicKeyPem;
             state.privateKeyPem = state.keyPair.privateKeyPem;
             refreshKeyMetadata(state);
             state.statusMessage = "Key pair generated successfully";
+        } catch (const RSAUtil::OperationCancelled&) {
+            state.statusMessage = "Key generation cancelled";
         } catch (const std::exception& ex) {
             state.statusMessage = std::string("Generation failed: ") + ex.what();
         }
+        state.keyGen = BackgroundKeyGen{};
+    }
+    if (state.keyGen.running()) {
+        const BackgroundKeyGen::Progress& progress = *state.keyGen.progress;
+        const int found = progress.primesFound;
+        const int needed = std::max(1, progress.primesNeeded.load());
+        char overlay[96];
+        std::snprintf(overlay, sizeof(overlay), "%d/%d primes, %llu candidates", found, needed,
+                      static_cast<unsigned long long>(progress.candidatesTested.load()));
+        ImGui::ProgressBar(static_cast<float>(found) / static_cast<float>(needed), ImVec2(-FLT_MIN, 0.0f), overlay);
+        if (ImGui::Button("Cancel generation")) {
+            state.keyGen.cancel();
+        }
+    } else if (ImGui::Button("Generate PEM key pair")) {
+        state.keyGen.start(state.keyBits, state.primes);
+        state.statusMessage = "Generating key pair in the background...";
     }
     ImGui::SameLine();
     if (ImGui::Button("Reset state")) {
@@ -289,7 +365,9 @@ static void DrawPemEncryptionTab(PemUiState& state) {
         } else {
             try {
                 const int padding = kPaddingValues[state.paddingIndex];
-                const std::vector<uint8_t> encrypted = RSAUtil::encryptTextToBytes(state.plaintext, state.keyPair, padding);
+                const std::vector<uint8_t> encrypted = state.paddingIndex == kHybridPaddingIndex
+                    ? RSAUtil::hybridEncryptText(state.plaintext, state.keyPair)
+                    : RSAUtil::encryptTextToBytes(state.plaintext, state.keyPair, padding);
                 state.ciphertextBase64 = encodeBase64(encrypted);
                 state.encryptStatus = "Encryption succeeded";
             } catch (const std::exception& ex) {
@@ -329,7 +407,12 @@ static void DrawPemDecryptionTab(PemUiState& state) {
             } else {
                 try {
                     const int padding = kPaddingValues[state.paddingIndex];
-                    state.decryptOutput = RSAUtil::decryptTextFromBytes(cipherBytes, state.keyPair, padding);
+                    if (state.paddingIndex == kHybridPaddingIndex) {
+                        RSAUtil::hybridDecryptToString(cipherBytes.data(), cipherBytes.size(), state.keyPair,
+                                                       state.decryptOutput);
+                    } else {
+                        state.decryptOutput = RSAUtil::decryptTextFromBytes(cipherBytes, state.keyPair, padding);
+                    }
                     state.decryptStatus = "Decryption succeeded";
                 } catch (const std::exception& ex) {
                     state.decryptStatus = std::string("Decryption failed: ") + ex.what();
@@ -397,7 +480,9 @@ static void DrawPemFileEncryptionTab(PemUiState& state) {
             } else {
                 try {
                     const int padding = kPaddingValues[state.paddingIndex];
-                    const std::vector<uint8_t> encrypted = RSAUtil::encryptTextToBytes(fileContent, state.keyPair, padding);
+                    const std::vector<uint8_t> encrypted = state.paddingIndex == kHybridPaddingIndex
+                        ? RSAUtil::hybridEncryptText(fileContent, state.keyPair)
+                        : RSAUtil::encryptTextToBytes(fileContent, state.keyPair, padding);
                     const std::string base64 = encodeBase64(encrypted);
                     state.ciphertextBase64 = base64;
                     state.encryptStatus = "Encryption succeeded (from file)";
@@ -472,10 +557,15 @@ static void DrawPemFileDecryptionTab(PemUiState& state) {
                 } else {
                     try {
                     const int padding = kPaddingValues[state.paddingIndex];
-                        const std::string decrypted = RSAUtil::decryptTextFromBytes(cipherBytes, state.keyPair, padding);
-                        state.decryptOutput = decrypted;
+                        if (state.paddingIndex == kHybridPaddingIndex) {
+                            RSAUtil::hybridDecryptToString(cipherBytes.data(), cipherBytes.size(), state.keyPair,
+                                                           state.decryptOutput);
+                        } else {
+                            RSAUtil::decryptToString(cipherBytes.data(), cipherBytes.size(), state.keyPair,
+                                                     state.decryptOutput, padding);
+                        }
                         state.decryptStatus = "Decryption succeeded (from file)";
-                        if (saveTextFile(outputPath, decrypted, error)) {
+                        if (saveTextFile(outputPath, state.decryptOutput, error)) {
                             state.decryptFileStatus = "File decrypted and plaintext written to output path.";
                         } else {
                             state.decryptFileStatus = error;
@@ -669,6 +759,15 @@ int main() {
     return 1;
 #endif
 
+    // OpenSSL is initialised up front (without openssl.cnf) so the first key load or encryption
+    // does not pay for it.
+    try {
+        RSAUtil::initializeOpenSSL(RSAUtil::InitProfile::FastStart);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+
     // 1. Create window and initialize graphics
     if (!InitializeWindowAndGraphics(1280, 800, "RSA_CPP GUI")) return 1;
 
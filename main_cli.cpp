@@ -4,13 +4,16 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 using std::string;
@@ -141,13 +144,36 @@ string readTextFile(const std::filesystem::path& path) {
 
 enum class Mode {
     Legacy = 0,
-    Pem = 1
+    Pem = 1,
+    LegacyPacked = 2
 };
 
 constexpr const char* kCliVersion = "RSA_CLI 1.0.0";
 
 const char* modeName(Mode mode) {
-    return mode == Mode::Legacy ? "Legacy long long mode" : "PEM/OpenSSL mode";
+    switch (mode) {
+    case Mode::Legacy:
+        return "Legacy long long mode";
+    case Mode::LegacyPacked:
+        return "Legacy packed mode (several bytes per value, length-framed)";
+    default:
+        return "PEM/OpenSSL mode";
+    }
+}
+
+// Both legacy modes share the integer key pair; they differ only in how bytes map to values.
+bool isLegacy(Mode mode) {
+    return mode == Mode::Legacy || mode == Mode::LegacyPacked;
+}
+
+vector<long long> legacyEncrypt(Mode mode, const string& plaintext, const RSAUtil::KeyPair& keyPair) {
+    return mode == Mode::LegacyPacked ? RSAUtil::encryptTextPacked(plaintext, keyPair)
+                                      : RSAUtil::encryptText(plaintext, keyPair);
+}
+
+string legacyDecrypt(Mode mode, const vector<long long>& ciphertext, const RSAUtil::KeyPair& keyPair) {
+    return mode == Mode::LegacyPacked ? RSAUtil::decryptTextPacked(ciphertext, keyPair)
+                                      : RSAUtil::decryptText(ciphertext, keyPair);
 }
 
 struct LegacyState {
@@ -187,6 +213,38 @@ string readLine(const string& prompt) {
     return line;
 }
 
+// Startup cost of a one-shot command, printed to stderr with -startup_report.
+struct StartupReport {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    RSAUtil::InitReport init;
+    bool enabled = false;
+
+    void firstOperationDone(const char* operation) const {
+        if (!enabled) {
+            return;
+        }
+        const auto sinceStart = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        std::cerr << "startup: OpenSSL init (" << (init.profile == RSAUtil::InitProfile::FastStart ? "fast" : "default")
+                  << ") " << init.elapsed.count() / 1000.0 << " ms, first " << operation << " done "
+                  << sinceStart.count() / 1000.0 << " ms after start" << std::endl;
+    }
+};
+
+// Prime-search progress on stderr, rewritten in place; finishes the line once every prime is found.
+RSAUtil::KeyGenProgressCallback consoleKeyGenProgress() {
+    return [done = false](const RSAUtil::KeyGenProgress& progress) mutable {
+        const bool finished = progress.primesFound >= progress.primesNeeded;
+        if (done || (!finished && progress.candidatesTested % 16 != 0 && progress.candidatesTested != 1)) {
+            return;
+        }
+        done = finished;
+        std::cerr << "\rSearching primes: " << progress.primesFound << "/" << progress.primesNeeded
+                  << " found, " << progress.candidatesTested << " candidates tested" << (finished ? "\n" : "")
+                  << std::flush;
+    };
+}
+
 void printSeparator() {
     std::cout << "----------------------------------------" << std::endl;
 }
@@ -194,11 +252,13 @@ void printSeparator() {
 } // namespace
 
 int main(int argc, char** argv) {
+    StartupReport startup;
     bool showHelp = false;
     bool showVersion = false;
     bool encryptCommand = false;
     bool decryptCommand = false;
     string commandType = "text";
+    string commandMode = "rsa";
     string commandInput;
     string commandInputPath;
     string commandPublicKey;
@@ -206,9 +266,13 @@ int main(int argc, char** argv) {
     string commandPrivateKey;
     string commandPrivateKeyPath;
     bool generateKeyCommand = false;
+    bool fillKeyPoolCommand = false;
     string generatePrivatePath;
     string generatePublicPath;
     int generateKeyBits = 2048;
+    int generatePrimes = 2;
+    string generateKeyPoolPath;
+    string initProfile = "fast";
 
     auto stripValue = [](string value) {
         return stripSurroundingQuotes(trim(std::move(value)));
@@ -226,6 +290,8 @@ int main(int argc, char** argv) {
             decryptCommand = true;
         } else if (arg == "-generate_key" || arg == "--generate_key") {
             generateKeyCommand = true;
+        } else if (arg == "-fill_key_pool" || arg == "--fill_key_pool") {
+            fillKeyPoolCommand = true;
         } else if (arg.rfind("-type=", 0) == 0) {
             commandType = stripValue(arg.substr(6));
         } else if (arg == "-type") {
@@ -234,6 +300,14 @@ int main(int argc, char** argv) {
                 return 1;
             }
             commandType = stripValue(argv[++i]);
+        } else if (arg.rfind("-mode=", 0) == 0) {
+            commandMode = stripValue(arg.substr(6));
+        } else if (arg == "-mode") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value after -mode\n";
+                return 1;
+            }
+            commandMode = stripValue(argv[++i]);
         } else if (arg.rfind("-input=", 0) == 0) {
             commandInput = stripValue(arg.substr(7));
         } else if (arg == "-input") {
@@ -326,6 +400,35 @@ int main(int argc, char** argv) {
                 std::cerr << "Invalid value for -length: " << lenStr << std::endl;
                 return 1;
             }
+        } else if (arg.rfind("-key_pool=", 0) == 0) {
+            generateKeyPoolPath = stripValue(arg.substr(10));
+        } else if (arg == "-key_pool") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value after -key_pool\n";
+                return 1;
+            }
+            generateKeyPoolPath = stripValue(argv[++i]);
+        } else if (arg.rfind("-primes=", 0) == 0 || arg == "-primes") {
+            string primesStr;
+            if (arg == "-primes") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Missing value after -primes\n";
+                    return 1;
+                }
+                primesStr = stripValue(argv[++i]);
+            } else {
+                primesStr = stripValue(arg.substr(8));
+            }
+            try {
+                generatePrimes = std::stoi(primesStr);
+            } catch (...) {
+                std::cerr << "Invalid value for -primes: " << primesStr << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("-init=", 0) == 0) {
+            initProfile = stripValue(arg.substr(6));
+        } else if (arg == "-startup_report") {
+            startup.enabled = true;
         } else if (generateKeyCommand && arg == "-length") {
             if (i + 1 >= argc) {
                 std::cerr << "Missing value after -length\n";
@@ -355,9 +458,18 @@ int main(int argc, char** argv) {
                   << "  RSA_CLI -decrypt -type=text -input=\"Base64\" -private_key=\"PEM\"\n"
                   << "                        # one-shot text decryption (alias: -descrypt)\n"
                   << "     (use -input_path and -private_key_path to read from files)\n"
+                  << "     (add -mode=hybrid to either command for RSA-OAEP + AES-256-GCM envelopes)\n"
                   << "  RSA_CLI -generate_key -length=2048 -public_key_path=pub.pem -private_key_path=priv.pem\n"
                   << "                        # generate PEM key pair and write to paths\n"
-                  << "     (length <512 will be rounded up automatically)\n\n"
+                  << "     (length <512 will be rounded up automatically)\n"
+                  << "     (add -primes=3 or -primes=4 for a multi-prime key: 3 needs >=1024 bits, 4 needs >=4096)\n"
+                  << "     (add -key_pool=spool.pem to take a pre-generated key from a spool saved 0600;\n"
+                  << "      a one-shot run does not wait for refills, so restock with -fill_key_pool)\n"
+                  << "  RSA_CLI -fill_key_pool -key_pool=spool.pem -length=2048\n"
+                  << "                        # generate keys until the spool holds 4 of that size (-primes applies)\n"
+                  << "  -init=fast|default    # fast (default) skips openssl.cnf and exit-time cleanup;\n"
+                  << "                        # default initialises OpenSSL with its config file\n"
+                  << "  -startup_report       # print OpenSSL init time and time to the first operation to stderr\n\n"
                   << "Interactive menu options:\n"
                   << "  1  Switch mode between legacy (integer) and PEM (OpenSSL)\n"
                   << "  2  Generate keys in current mode\n"
@@ -372,7 +484,8 @@ int main(int argc, char** argv) {
                   << "  11 Save current keys to files\n"
                   << "  12 Encrypt file to file\n"
                   << "  13 Decrypt file to file\n"
-                  << "  14 Exit\n";
+                  << "  14 Switch legacy packing: one byte per integer or as many as the modulus allows\n"
+                  << "  15 Exit\n";
         return 0;
     }
 
@@ -381,8 +494,27 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    if ((encryptCommand ? 1 : 0) + (decryptCommand ? 1 : 0) + (generateKeyCommand ? 1 : 0) > 1) {
-        std::cerr << "Cannot combine encrypt, decrypt, or generate commands simultaneously.\n";
+    if (initProfile != "fast" && initProfile != "default") {
+        std::cerr << "Unsupported init profile: " << initProfile << " (expected fast or default)" << std::endl;
+        return 1;
+    }
+    try {
+        startup.init = RSAUtil::initializeOpenSSL(initProfile == "fast" ? RSAUtil::InitProfile::FastStart
+                                                                         : RSAUtil::InitProfile::Default);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+
+    if ((encryptCommand ? 1 : 0) + (decryptCommand ? 1 : 0) + (generateKeyCommand ? 1 : 0)
+            + (fillKeyPoolCommand ? 1 : 0) > 1) {
+        std::cerr << "Cannot combine encrypt, decrypt, generate, or fill_key_pool commands simultaneously.\n";
+        return 1;
+    }
+
+    const bool hybridMode = commandMode == "hybrid";
+    if (!hybridMode && commandMode != "rsa" && commandMode != "pem") {
+        std::cerr << "Unsupported mode: " << commandMode << " (expected rsa or hybrid)" << std::endl;
         return 1;
     }
 
@@ -423,10 +555,11 @@ int main(int argc, char** argv) {
         }
 
         try {
-            RSAUtil::PemKeyPair pair{};
-            pair.publicKeyPem = publicKeyPem;
-            pair.keyBits = RSAUtil::getKeyBitsFromPublicKey(publicKeyPem);
-            const vector<uint8_t> encrypted = RSAUtil::encryptTextToBytes(plaintext, pair);
+            const RSAUtil::PublicKey publicKey(publicKeyPem);
+            const vector<uint8_t> encrypted = hybridMode
+                ? RSAUtil::hybridEncryptText(plaintext, publicKey)
+                : RSAUtil::encryptTextToBytes(plaintext, publicKey);
+            startup.firstOperationDone("encryption");
             const string base64 = encodeBase64(encrypted);
             std::cout << base64 << std::endl;
             return 0;
@@ -474,10 +607,14 @@ int main(int argc, char** argv) {
 
         try {
             const vector<uint8_t> cipherBytes = decodeBase64(ciphertext);
-            RSAUtil::PemKeyPair pair{};
-            pair.privateKeyPem = privateKeyPem;
-            const vector<uint8_t> plainBytes = RSAUtil::decryptBytes(cipherBytes, pair);
-            string plaintext(plainBytes.begin(), plainBytes.end());
+            const RSAUtil::PrivateKey privateKey(privateKeyPem);
+            string plaintext;
+            if (hybridMode) {
+                RSAUtil::hybridDecryptInto(cipherBytes.data(), cipherBytes.size(), privateKey, plaintext);
+            } else {
+                RSAUtil::decryptToString(cipherBytes.data(), cipherBytes.size(), privateKey, plaintext);
+            }
+            startup.firstOperationDone("decryption");
             std::cout << plaintext << std::endl;
             return 0;
         } catch (const std::exception& ex) {
@@ -496,7 +633,18 @@ int main(int argc, char** argv) {
             generateKeyBits = 512;
         }
         try {
-            const RSAUtil::PemKeyPair pair = RSAUtil::generatePemKeyPair(generateKeyBits);
+            std::unique_ptr<RSAUtil::KeyPool> keyPool;
+            if (!generateKeyPoolPath.empty()) {
+                RSAUtil::KeyPoolOptions options;
+                options.primes = generatePrimes;
+                options.spoolPath = generateKeyPoolPath;
+                keyPool = std::make_unique<RSAUtil::KeyPool>(options);
+            }
+            const RSAUtil::PemKeyPair pair = keyPool
+                ? keyPool->acquire(generateKeyBits)
+                : RSAUtil::generatePemKeyPair(generateKeyBits, generatePrimes, consoleKeyGenProgress(),
+                                              RSAUtil::CancellationToken());
+            startup.firstOperationDone("key generation");
             const string sanitizedPublic = stripSurroundingQuotes(generatePublicPath);
             const string sanitizedPrivate = stripSurroundingQuotes(generatePrivatePath);
             if (!generatePublicPath.empty()) {
@@ -505,13 +653,25 @@ int main(int argc, char** argv) {
             if (!generatePrivatePath.empty()) {
                 WriteStringToBinaryFile(sanitizedPrivate, pair.privateKeyPem);
             }
-            std::cout << "Generated " << generateKeyBits << "-bit key pair.\n";
+            std::cout << "Generated " << generateKeyBits << "-bit key pair";
+            if (generatePrimes > 2) {
+                std::cout << " with " << generatePrimes << " primes";
+            }
+            std::cout << ".\n";
             if (!generatePublicPath.empty()) {
                 std::cout << "Public key saved to: " << sanitizedPublic << std::endl;
             }
             if (!generatePrivatePath.empty()) {
                 std::cout << "Private key saved to: " << sanitizedPrivate << std::endl;
             }
+            if (keyPool) {
+                const size_t left = keyPool->available(generateKeyBits);
+                std::cout << "Key pool: " << left << " ready key(s) left in " << generateKeyPoolPath;
+                if (left == 0) {
+                    std::cout << " (restock with -fill_key_pool)";
+                }
+                std::cout << std::endl;
+            }
             return 0;
         } catch (const std::exception& ex) {
             std::cerr << "Key generation failed: " << ex.what() << std::endl;
@@ -519,6 +679,28 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (fillKeyPoolCommand) {
+        if (generateKeyPoolPath.empty()) {
+            std::cerr << "Provide -key_pool=<spool path> to fill.\n";
+            return 1;
+        }
+        generateKeyBits = std::max(generateKeyBits, 512);
+        try {
+            RSAUtil::KeyPoolOptions options;
+            options.primes = generatePrimes;
+            options.spoolPath = generateKeyPoolPath;
+            options.workers = std::max(1u, std::thread::hardware_concurrency());
+            RSAUtil::KeyPool keyPool(options);
+            keyPool.fill(generateKeyBits);
+            std::cout << "Key pool: " << keyPool.available(generateKeyBits) << " ready " << generateKeyBits
+                      << "-bit key(s) in " << generateKeyPoolPath << std::endl;
+            return 0;
+        } catch (const std::exception& ex) {
+            std::cerr << "Filling key pool failed: " << ex.what() << std::endl;
+            return 1;
+        }
+    }
+
     std::cout << "RSA Encryption/Decryption CLI Tool" << std::endl;
     std::cout << "===================================" << std::endl;
 
@@ -543,18 +725,19 @@ int main(int argc, char** argv) {
         std::cout << "11. Save current keys to files" << std::endl;
         std::cout << "12. Encrypt file to file" << std::endl;
         std::cout << "13. Decrypt file to file" << std::endl;
-        std::cout << "14. Exit" << std::endl;
+        std::cout << "14. Switch legacy packing" << std::endl;
+        std::cout << "15. Exit" << std::endl;
 
-        const int choice = readInt("Choose an option (1-14): ", 1, 14);
+        const int choice = readInt("Choose an option (1-15): ", 1, 15);
 
         switch (choice) {
         case 1: {
-            mode = (mode == Mode::Legacy) ? Mode::Pem : Mode::Legacy;
+            mode = isLegacy(mode) ? Mode::Pem : Mode::Legacy;
             std::cout << "Switched to " << modeName(mode) << std::endl;
             break;
         }
         case 2: {
-            if (mode == Mode::Legacy) {
+            if (isLegacy(mode)) {
                 legacy.keyPair = RSAUtil::generateKeyPair();
                 legacy.hasKey = true;
                 std::cout << "Generated legacy key pair." << std::endl;
@@ -571,7 +754,7 @@ int main(int argc, char** argv) {
                 }
                 bits = std::clamp(bits, 512, 16384);
                 try {
-                    pem.keyPair = RSAUtil::generatePemKeyPair(bits);
+                    pem.keyPair = RSAUtil::generatePemKeyPair(bits, 2, consoleKeyGenProgress(), RSAUtil::CancellationToken());
                     pem.hasPublic = true;
                     pem.hasPrivate = true;
                     pem.keyBits = pem.keyPair.keyBits;
@@ -583,7 +766,7 @@ int main(int argc, char** argv) {
             break;
         }
         case 3: {
-            if (mode == Mode::Legacy) {
+            if (isLegacy(mode)) {
                 if (!legacy.hasKey) {
                     legacy.keyPair = RSAUtil::KeyPair();
                 }
@@ -629,7 +812,7 @@ int main(int argc, char** argv) {
             break;
         }
         case 4: {
-            if (mode == Mode::Legacy) {
+            if (isLegacy(mode)) {
                 if (legacy.hasKey) {
                     RSAUtil::printKeyInfo(legacy.keyPair);
                 } else {
@@ -653,14 +836,14 @@ int main(int argc, char** argv) {
             break;
         }
         case 5: {
-            if (mode == Mode::Legacy) {
+            if (isLegacy(mode)) {
                 if (!legacy.hasKey) {
                     std::cout << "Generate or import legacy keys first." << std::endl;
                     break;
                 }
                 const string plaintext = readLine("Text to encrypt: ");
                 try {
-                    vector<long long> encrypted = RSAUtil::encryptText(plaintext, legacy.keyPair);
+                    vector<long long> encrypted = legacyEncrypt(mode, plaintext, legacy.keyPair);
                     result = encodeCiphertextBase64(encrypted);
                     std::cout << "Encryption complete. Base64 ciphertext:\n" << result << std::endl;
                 } catch (const std::exception& e) {
@@ -683,7 +866,7 @@ int main(int argc, char** argv) {
             break;
         }
         case 6: {
-            if (mode == Mode::Legacy) {
+            if (isLegacy(mode)) {
                 if (!legacy.hasKey) {
                     std::cout << "Generate or import legacy keys first." << std::endl;
                     break;
@@ -691,7 +874,7 @@ int main(int argc, char** argv) {
                 string ciphertextInput = readLine("Enter Base64 ciphertext or comma-separated numbers: ");
                 try {
                     const vector<long long> encrypted = parseCiphertext(ciphertextInput);
-                    const string decrypted = RSAUtil::decryptText(encrypted, legacy.keyPair);
+                    const string decrypted = legacyDecrypt(mode, encrypted, legacy.keyPair);
                     result = decrypted;
                     std::cout << "Decrypted text: \"" << decrypted << "\"" << std::endl;
                 } catch (const std::exception& e) {
@@ -737,20 +920,19 @@ int main(int argc, char** argv) {
             const string sourcePath = stripSurroundingQuotes(trim(readLine("Source binary file path: ")));
             try {
                 const string binaryData = ReadBinaryFileToString(sourcePath);
-                if (mode == Mode::Legacy) {
+                if (isLegacy(mode)) {
                     if (!legacy.hasKey) {
                         std::cout << "Generate or import legacy keys first." << std::endl;
                         break;
                     }
-                    const vector<long long> encrypted = RSAUtil::encryptText(binaryData, legacy.keyPair);
+                    const vector<long long> encrypted = legacyEncrypt(mode, binaryData, legacy.keyPair);
                     result = encodeCiphertextBase64(encrypted);
                 } else {
                     if (!pem.hasPublic) {
                         std::cout << "Load or generate a PEM public key first." << std::endl;
                         break;
                     }
-                    const vector<uint8_t> plainBytes(binaryData.begin(), binaryData.end());
-                    const vector<uint8_t> encrypted = RSAUtil::encryptBytes(plainBytes, pem.keyPair);
+                    const vector<uint8_t> encrypted = RSAUtil::encryptTextToBytes(binaryData, pem.keyPair);
                     result = encodeBase64(encrypted);
                 }
                 std::cout << "Encryption complete. Base64 ciphertext:\n" << result << std::endl;
@@ -762,13 +944,13 @@ int main(int argc, char** argv) {
         case 9: {
             const string ciphertextInput = readLine("Enter Base64 ciphertext (whitespace ignored): ");
             try {
-                if (mode == Mode::Legacy) {
+                if (isLegacy(mode)) {
                     if (!legacy.hasKey) {
                         std::cout << "Generate or import legacy keys first." << std::endl;
                         break;
                     }
                     const vector<long long> encrypted = parseCiphertext(ciphertextInput);
-                    const string decrypted = RSAUtil::decryptText(encrypted, legacy.keyPair);
+                    const string decrypted = legacyDecrypt(mode, encrypted, legacy.keyPair);
                     result = decrypted;
                     std::cout << "Decryption complete." << std::endl;
                 } else {
@@ -777,14 +959,13 @@ int main(int argc, char** argv) {
                         break;
                     }
                     const vector<uint8_t> cipherBytes = decodeBase64(ciphertextInput);
-                    const vector<uint8_t> plainBytes = RSAUtil::decryptBytes(cipherBytes, pem.keyPair);
-                    result.assign(plainBytes.begin(), plainBytes.end());
+                    RSAUtil::decryptToString(cipherBytes.data(), cipherBytes.size(), pem.keyPair, result);
                     std::cout << "Decryption complete. Use option 7 to save the data." << std::endl;
-                    if (!plainBytes.empty()) {
-                        const size_t previewLen = std::min<size_t>(plainBytes.size(), 32);
-                        const string preview = cppcodec::base64_rfc4648::encode(plainBytes.data(), previewLen);
+                    if (!result.empty()) {
+                        const size_t previewLen = std::min<size_t>(result.size(), 32);
+                        const string preview = cppcodec::base64_rfc4648::encode(result.data(), previewLen);
                         std::cout << "Base64 preview (first " << previewLen << " bytes): " << preview;
-                        if (plainBytes.size() > previewLen) {
+                        if (result.size() > previewLen) {
                             std::cout << "...";
                         }
                         std::cout << std::endl;
@@ -817,7 +998,7 @@ int main(int argc, char** argv) {
             break;
         }
         case 11: {
-            if (mode == Mode::Legacy) {
+            if (isLegacy(mode)) {
                 if (!legacy.hasKey) {
                     std::cout << "Generate or import legacy keys first." << std::endl;
                     break;
@@ -885,7 +1066,7 @@ int main(int argc, char** argv) {
             break;
         }
         case 12: {
-            if (mode == Mode::Legacy && !legacy.hasKey) {
+            if (isLegacy(mode) && !legacy.hasKey) {
                 std::cout << "Generate or import legacy keys first." << std::endl;
                 break;
             }
@@ -897,12 +1078,11 @@ int main(int argc, char** argv) {
             const string targetPath = stripSurroundingQuotes(trim(readLine("Target file path (ciphertext output): ")));
             try {
                 const string binaryData = ReadBinaryFileToString(sourcePath);
-                if (mode == Mode::Legacy) {
-                    const vector<long long> encrypted = RSAUtil::encryptText(binaryData, legacy.keyPair);
+                if (isLegacy(mode)) {
+                    const vector<long long> encrypted = legacyEncrypt(mode, binaryData, legacy.keyPair);
                     result = encodeCiphertextBase64(encrypted);
                 } else {
-                    const vector<uint8_t> plainBytes(binaryData.begin(), binaryData.end());
-                    const vector<uint8_t> encrypted = RSAUtil::encryptBytes(plainBytes, pem.keyPair);
+                    const vector<uint8_t> encrypted = RSAUtil::encryptTextToBytes(binaryData, pem.keyPair);
                     result = encodeBase64(encrypted);
                 }
                 WriteStringToBinaryFile(targetPath, result);
@@ -913,7 +1093,7 @@ int main(int argc, char** argv) {
             break;
         }
         case 13: {
-            if (mode == Mode::Legacy && !legacy.hasKey) {
+            if (isLegacy(mode) && !legacy.hasKey) {
                 std::cout << "Generate or import legacy keys first." << std::endl;
                 break;
             }
@@ -925,13 +1105,12 @@ int main(int argc, char** argv) {
             const string targetPath = stripSurroundingQuotes(trim(readLine("Target file path (plaintext output): ")));
             try {
                 const string cipherData = ReadBinaryFileToString(cipherPath);
-                if (mode == Mode::Legacy) {
+                if (isLegacy(mode)) {
                     const vector<long long> encrypted = parseCiphertext(cipherData);
-                    result = RSAUtil::decryptText(encrypted, legacy.keyPair);
+                    result = legacyDecrypt(mode, encrypted, legacy.keyPair);
                 } else {
                     const vector<uint8_t> cipherBytes = decodeBase64(cipherData);
-                    const vector<uint8_t> plainBytes = RSAUtil::decryptBytes(cipherBytes, pem.keyPair);
-                    result.assign(plainBytes.begin(), plainBytes.end());
+                    RSAUtil::decryptToString(cipherBytes.data(), cipherBytes.size(), pem.keyPair, result);
                 }
                 WriteStringToBinaryFile(targetPath, result);
                 std::cout << "Decryption complete. Wrote plaintext to: " << targetPath << std::endl;
@@ -941,6 +1120,19 @@ int main(int argc, char** argv) {
             break;
         }
         case 14: {
+            mode = mode == Mode::LegacyPacked ? Mode::Legacy : Mode::LegacyPacked;
+            std::cout << "Switched to " << modeName(mode) << std::endl;
+            if (mode == Mode::LegacyPacked && legacy.hasKey) {
+                try {
+                    std::cout << "Current key packs " << RSAUtil::packedBytesPerValue(legacy.keyPair)
+                              << " byte(s) per value." << std::endl;
+                } catch (const std::exception& e) {
+                    std::cout << "Current key cannot be used for packing: " << e.what() << std::endl;
+                }
+            }
+            break;
+        }
+        case 15: {
             std::cout << "Goodbye!" << std::endl;
             return 0;
         }
@@ -0,0 +1,534 @@
+#include "RSA.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int expect_true(bool condition) {
+    return condition ? 0 : 1;
+}
+
+template <typename Fn>
+int expect_throws(Fn&& fn) {
+    try {
+        fn();
+    } catch (const std::exception&) {
+        return 0;
+    }
+    return 1;
+}
+
+}  // namespace
+
+int main() {
+    // The first initialisation picks the profile; later ones only report it. This must stay the
+    // first OpenSSL use in the process: nothing above it (including static initialisers) may touch RSAUtil.
+    if (expect_true(RSAUtil::initializeOpenSSL(RSAUtil::InitProfile::FastStart).applied &&
+                    !RSAUtil::initializeOpenSSL().applied &&
+                    RSAUtil::initializeOpenSSL().profile == RSAUtil::InitProfile::FastStart)) {
+        return 1;
+    }
+
+    const RSAUtil::PemKeyPair pair = RSAUtil::generatePemKeyPair(1024);
+    const std::string message = "The quick brown fox jumps over the lazy dog";
+    const std::vector<uint8_t> bytes(message.begin(), message.end());
+
+    // Parsed key handles and the PEM string API must interoperate.
+    const RSAUtil::PublicKey publicKey(pair);
+    const RSAUtil::PrivateKey privateKey(pair);
+    if (expect_true(publicKey.valid() && privateKey.valid())) {
+        return 1;
+    }
+    if (expect_true(publicKey.keyBits() == 1024 && privateKey.size() == 128)) {
+        return 1;
+    }
+    if (expect_true(RSAUtil::getKeyBitsFromPublicKey(pair.publicKeyPem) == 1024)) {
+        return 1;
+    }
+
+    const std::vector<uint8_t> viaHandle = RSAUtil::encryptBytes(bytes, publicKey);
+    if (expect_true(RSAUtil::decryptBytes(viaHandle, pair) == bytes)) {
+        return 1;
+    }
+    const std::vector<uint8_t> viaPem = RSAUtil::encryptTextToBytes(message, pair, RSA_PKCS1_PADDING);
+    if (expect_true(RSAUtil::decryptTextFromBytes(viaPem, privateKey, RSA_PKCS1_PADDING) == message)) {
+        return 1;
+    }
+
+    // Repeated PemKeyPair calls are served from the parsed-key cache.
+    RSAUtil::clearKeyCache();
+    const RSAUtil::KeyCacheStats before = RSAUtil::keyCacheStats();
+    RSAUtil::encryptBytes(bytes, pair);
+    RSAUtil::encryptBytes(bytes, pair);
+    const RSAUtil::KeyCacheStats after = RSAUtil::keyCacheStats();
+    if (expect_true(after.misses - before.misses == 1 && after.hits - before.hits == 1 && after.size == 1)) {
+        return 1;
+    }
+    RSAUtil::setKeyCacheCapacity(0);
+    if (expect_true(RSAUtil::keyCacheStats().size == 0 && RSAUtil::decryptBytes(viaHandle, pair) == bytes)) {
+        return 1;
+    }
+
+    // Caller-owned buffers: exact ciphertext size, and a plaintext buffer smaller than the ciphertext.
+    std::vector<uint8_t> cipherBuffer(RSAUtil::encryptedSize(publicKey, bytes.size()));
+    if (expect_true(RSAUtil::encryptInto(bytes.data(), bytes.size(), publicKey,
+                                         cipherBuffer.data(), cipherBuffer.size()) == cipherBuffer.size())) {
+        return 1;
+    }
+    std::vector<uint8_t> plainBuffer(RSAUtil::maxDecryptedSize(privateKey, cipherBuffer.size()));
+    const size_t plainSize = RSAUtil::decryptInto(cipherBuffer.data(), cipherBuffer.size(), privateKey,
+                                                  plainBuffer.data(), plainBuffer.size());
+    if (expect_true(plainBuffer.size() < cipherBuffer.size() &&
+                    std::vector<uint8_t>(plainBuffer.begin(), plainBuffer.begin() + plainSize) == bytes)) {
+        return 1;
+    }
+    if (expect_throws([&] { RSAUtil::encryptInto(bytes.data(), bytes.size(), publicKey, cipherBuffer.data(), 10); })) {
+        return 1;
+    }
+    std::string decoded = "stale contents";
+    RSAUtil::decryptToString(cipherBuffer.data(), cipherBuffer.size(), privateKey, decoded);
+    if (expect_true(decoded == message &&
+                    RSAUtil::decryptTextFromBytes(cipherBuffer.data(), cipherBuffer.size(), pair) == message)) {
+        return 1;
+    }
+
+    // Block-parallel paths keep the block order of the serial ones.
+    std::vector<uint8_t> large(10000);
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    RSAUtil::setParallelConfig({4, 0, 0});
+    const std::vector<uint8_t> parallelCipher = RSAUtil::encryptBytes(large, publicKey);
+    if (expect_true(RSAUtil::decryptBytes(parallelCipher, privateKey, RSA_PKCS1_OAEP_PADDING) == large)) {
+        return 1;
+    }
+    RSAUtil::setParallelConfig({1, 0, 0});
+    if (expect_true(parallelCipher.size() % 128 == 0 && RSAUtil::decryptBytes(parallelCipher, privateKey) == large)) {
+        return 1;
+    }
+    RSAUtil::setParallelConfig({});
+
+    // Fixed-geometry engines agree with the runtime API and reject keys of another size.
+    using Engine1024 = RSAUtil::FixedEngine<1024, RSAUtil::Padding::OaepSha1>;
+    static_assert(Engine1024::chunkSize == 86 && Engine1024::encryptedSize(87) == 256, "OAEP geometry");
+    static_assert(RSAUtil::FixedEngine<2048, RSAUtil::Padding::Pkcs1>::base64BlockSize == 344, "Base64 length");
+    {
+        Engine1024::Block sealedBlock;
+        std::vector<uint8_t> fixedOut(Engine1024::maxDecryptedSize(Engine1024::blockSize));
+        if (expect_true(Engine1024::accepts(publicKey) &&
+                        Engine1024::encryptInto(bytes.data(), bytes.size(), publicKey, sealedBlock.data(), sealedBlock.size()) == 128 &&
+                        Engine1024::decryptInto(sealedBlock.data(), sealedBlock.size(), privateKey, fixedOut.data(), fixedOut.size()) == bytes.size() &&
+                        std::equal(bytes.begin(), bytes.end(), fixedOut.begin()) &&
+                        RSAUtil::decryptBytes(sealedBlock.data(), sealedBlock.size(), privateKey) == bytes)) {
+            return 1;
+        }
+        if (expect_throws([&] {
+                RSAUtil::FixedEngine<2048, RSAUtil::Padding::OaepSha1>::Block block;
+                RSAUtil::FixedEngine<2048, RSAUtil::Padding::OaepSha1>::encryptInto(bytes.data(), bytes.size(), publicKey, block.data(), block.size());
+            })) {
+            return 1;
+        }
+    }
+
+#if RSAUTIL_HAS_PMR
+    // pmr overloads return results allocated from the caller's resource (the upstream here refuses to
+    // allocate, so results that outgrow the arena would throw).
+    {
+        std::array<std::byte, 64 * 1024> storage;
+        std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+        const std::pmr::vector<uint8_t> sealedPmr = RSAUtil::encryptBytes(large.data(), large.size(), publicKey, &arena);
+        const std::pmr::vector<uint8_t> openedPmr = RSAUtil::decryptBytes(sealedPmr.data(), sealedPmr.size(), privateKey, &arena);
+        const std::pmr::vector<uint8_t> envelopePmr = RSAUtil::hybridEncryptBytes(large.data(), large.size(), publicKey, &arena);
+        const std::pmr::vector<uint8_t> openedEnvelope = RSAUtil::hybridDecryptBytes(envelopePmr.data(), envelopePmr.size(), privateKey, &arena);
+        std::pmr::string text(&arena);
+        RSAUtil::decryptToString(viaHandle.data(), viaHandle.size(), privateKey, text);
+        const std::vector<long long> legacy{0, -5, 9223372036854775807LL};
+        const std::pmr::string decimal = RSAUtil::ciphertextToString(legacy, &arena);
+        const std::pmr::vector<long long> parsed = RSAUtil::stringToCiphertext(decimal, &arena);
+        // Both overloads accept the same loosely formatted input.
+        const std::string loose = "1, 2,+3,4x , \t-5";
+        const std::pmr::vector<long long> looseParsed = RSAUtil::stringToCiphertext(loose, &arena);
+        const std::vector<long long> looseExpected = RSAUtil::stringToCiphertext(loose);
+        if (expect_true(std::equal(openedPmr.begin(), openedPmr.end(), large.begin(), large.end()) &&
+                        std::equal(openedEnvelope.begin(), openedEnvelope.end(), large.begin(), large.end()) &&
+                        std::string_view(text) == message && std::string_view(decimal) == RSAUtil::ciphertextToString(legacy) &&
+                        std::equal(parsed.begin(), parsed.end(), legacy.begin(), legacy.end()) &&
+                        std::equal(looseParsed.begin(), looseParsed.end(), looseExpected.begin(), looseExpected.end()))) {
+            return 1;
+        }
+        if (expect_throws([&] { RSAUtil::stringToCiphertext(std::string_view("1, ,2"), &arena); })) {
+            return 1;
+        }
+    }
+#endif
+
+    // Streaming objects accept input split at arbitrary points and match the one-shot API.
+    RSAUtil::Encryptor encryptor(publicKey);
+    std::vector<uint8_t> streamed;
+    for (size_t offset = 0, step = 1; offset < large.size(); offset += step, step = step * 3 + 1) {
+        encryptor.update(large.data() + offset, std::min(step, large.size() - offset), streamed);
+        if (expect_true(encryptor.pending() < 128)) {
+            return 1;
+        }
+    }
+    encryptor.finish(streamed);
+    RSAUtil::Decryptor decryptor(pair);
+    std::vector<uint8_t> restored;
+    for (size_t offset = 0; offset < streamed.size(); offset += 77) {
+        decryptor.update(streamed.data() + offset, std::min<size_t>(77, streamed.size() - offset), restored);
+    }
+    decryptor.finish();
+    if (expect_true(streamed.size() == parallelCipher.size() && restored == large)) {
+        return 1;
+    }
+    decryptor.update(streamed.data(), 5, restored);
+    if (expect_throws([&] { decryptor.finish(); })) {
+        return 1;
+    }
+
+    // Hybrid envelopes round-trip, including empty payloads, and reject any modified byte.
+    std::vector<uint8_t> envelope = RSAUtil::hybridEncryptBytes(large, pair);
+    if (expect_true(envelope.size() == RSAUtil::hybridEncryptedSize(publicKey, large.size()) &&
+                    RSAUtil::hybridDecryptBytes(envelope, privateKey) == large)) {
+        return 1;
+    }
+    if (expect_true(RSAUtil::hybridDecryptBytes(RSAUtil::hybridEncryptText("", publicKey), pair).empty())) {
+        return 1;
+    }
+    for (size_t position : {size_t{5}, size_t{10}, size_t{140}, envelope.size() / 2, envelope.size() - 1}) {
+        envelope[position] ^= 0x01;
+        if (expect_throws([&] { RSAUtil::hybridDecryptBytes(envelope, privateKey); })) {
+            return 1;
+        }
+        envelope[position] ^= 0x01;
+    }
+    if (expect_throws([&] { RSAUtil::hybridDecryptBytes(parallelCipher, privateKey); })) {
+        return 1;
+    }
+
+    // Batches keep message order and boundaries, including empty messages and multi-block ones.
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 40; ++i) {
+        tokens.push_back(std::string(static_cast<size_t>(i * 7 % 150), static_cast<char>('a' + i % 26)));
+    }
+    const std::vector<std::string_view> tokenViews(tokens.begin(), tokens.end());
+    RSAUtil::setParallelConfig({4, 0, 0});
+    const RSAUtil::ByteArena sealed = RSAUtil::encryptMany(tokenViews, pair);
+    const RSAUtil::ByteArena opened = RSAUtil::decryptMany(sealed, privateKey);
+    RSAUtil::setParallelConfig({});
+    if (expect_true(sealed.size() == tokens.size() && opened.size() == tokens.size())) {
+        return 1;
+    }
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (expect_true(opened.view(i) == tokens[i] && sealed.itemSize(i) % 128 == 0)) {
+            return 1;
+        }
+    }
+
+    // Signatures verify under both paddings; verifyMany flags exactly the corrupted entries.
+    for (int padding : {RSA_PKCS1_PSS_PADDING, RSA_PKCS1_PADDING}) {
+        const std::vector<uint8_t> signature = RSAUtil::sign(bytes, privateKey, padding);
+        std::vector<uint8_t> forged = signature;
+        forged[5] ^= 0x01;
+        if (expect_true(signature.size() == 128 && RSAUtil::verify(bytes, signature, publicKey, padding) &&
+                        !RSAUtil::verify(bytes, forged, publicKey, padding) && !RSAUtil::verify(large, signature, pair, padding))) {
+            return 1;
+        }
+    }
+    std::vector<std::string> signatures;
+    for (const std::string& token : tokens) {
+        const std::vector<uint8_t> signature = RSAUtil::sign(std::vector<uint8_t>(token.begin(), token.end()), pair);
+        signatures.emplace_back(signature.begin(), signatures.size() % 7 == 3 ? signature.end() - 1 : signature.end());
+    }
+    RSAUtil::setParallelConfig({4, 0, 0});
+    const std::vector<uint8_t> verified = RSAUtil::verifyMany(tokenViews, {signatures.begin(), signatures.end()}, publicKey);
+    RSAUtil::setParallelConfig({});
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (expect_true(verified[i] == (i % 7 == 3 ? 0 : 1))) {
+            return 1;
+        }
+    }
+    if (expect_throws([&] { RSAUtil::sign(bytes, privateKey, RSA_PKCS1_OAEP_PADDING); })) {
+        return 1;
+    }
+
+    // Async operations complete on the executor; the in-flight limit bounds queued work.
+    RSAUtil::setAsyncConfig({1, 2});
+    std::vector<std::future<std::vector<uint8_t>>> pending;
+    for (int i = 0; i < 6; ++i) {
+        pending.push_back(RSAUtil::decryptAsync(viaHandle, privateKey));
+        if (expect_true(RSAUtil::detail::asyncExecutor()->inFlight() <= 2)) {
+            return 1;
+        }
+    }
+    for (auto& future : pending) {
+        if (expect_true(future.get() == bytes)) {
+            return 1;
+        }
+    }
+    std::promise<std::vector<uint8_t>> callbackResult;
+    RSAUtil::encryptAsync(bytes, publicKey, [&](std::vector<uint8_t> result, std::exception_ptr error) {
+        if (error) {
+            callbackResult.set_exception(error);
+        } else {
+            callbackResult.set_value(std::move(result));
+        }
+    });
+    if (expect_true(RSAUtil::decryptBytes(callbackResult.get_future().get(), privateKey) == bytes)) {
+        return 1;
+    }
+    std::future<std::vector<uint8_t>> failed = RSAUtil::decryptAsync({1, 2, 3}, pair);
+    if (expect_throws([&] { failed.get(); })) {
+        return 1;
+    }
+    if (expect_true(RSAUtil::generateAsync(1024).get().keyBits == 1024)) {
+        return 1;
+    }
+    // A throwing handler is contained, and a handler may retire its own executor.
+    RSAUtil::encryptAsync(bytes, publicKey, [](std::vector<uint8_t>, std::exception_ptr) {
+        throw std::runtime_error("handler failure");
+    });
+    std::promise<void> reconfigured;
+    RSAUtil::encryptAsync(bytes, publicKey, [&](std::vector<uint8_t>, std::exception_ptr) {
+        RSAUtil::setAsyncConfig({2, 4});
+        reconfigured.set_value();
+    });
+    reconfigured.get_future().get();
+    if (expect_true(RSAUtil::encryptAsync(bytes, publicKey).get().size() == viaHandle.size())) {
+        return 1;
+    }
+    RSAUtil::setAsyncConfig({});
+
+    // Fiber jobs interleave on the calling thread: multi-block jobs pause between blocks.
+    {
+        RSAUtil::FiberScheduler fibers;
+        std::future<std::vector<uint8_t>> sealedLarge = fibers.encrypt(large, publicKey);
+        std::future<std::vector<uint8_t>> openedSmall = fibers.decrypt(viaHandle, privateKey);
+        std::future<RSAUtil::PemKeyPair> generated = fibers.generate(1024);
+        std::future<std::vector<uint8_t>> broken = fibers.decrypt({1, 2, 3}, privateKey);
+        if (RSAUtil::FiberScheduler::fibersAvailable() &&
+            expect_true(fibers.poll() >= (RSAUtil::detail::kFiberKeyGeneration ? 2u : 1u))) {
+            return 1;
+        }
+        fibers.run();
+        if (expect_true(RSAUtil::decryptBytes(sealedLarge.get(), privateKey) == large &&
+                        openedSmall.get() == bytes && generated.get().keyBits == 1024 && fibers.pending() == 0)) {
+            return 1;
+        }
+        if (expect_throws([&] { broken.get(); })) {
+            return 1;
+        }
+    }
+
+    // Multi-prime keys load through the regular PEM paths.
+    const RSAUtil::PemKeyPair threePrime = RSAUtil::generatePemKeyPair(1024, 3);
+    if (expect_true(RSAUtil::decryptBytes(RSAUtil::encryptBytes(large, threePrime), threePrime) == large)) {
+        return 1;
+    }
+    if (expect_throws([] { RSAUtil::generatePemKeyPair(1024, 4); })) {
+        return 1;
+    }
+
+    // The parallel prime search assembles the key itself; CRT decryption proves the components agree.
+    RSAUtil::setParallelConfig({4, 0, 0, 512});
+    const RSAUtil::PemKeyPair searched = RSAUtil::generatePemKeyPair(1025);
+    RSAUtil::setParallelConfig({});
+    if (expect_true(EVP_PKEY_bits(RSAUtil::PublicKey(searched).get()) == 1025 &&
+                    searched.privateKeyPem.find("BEGIN RSA PRIVATE KEY") != std::string::npos &&
+                    RSAUtil::decryptBytes(RSAUtil::encryptBytes(large, searched), searched) == large)) {
+        return 1;
+    }
+
+    // Progress is reported per candidate and per prime; cancellation stops both generator paths early.
+    RSAUtil::KeyGenProgress lastProgress;
+    RSAUtil::generatePemKeyPair(1024, 2, [&](const RSAUtil::KeyGenProgress& update) { lastProgress = update; },
+                                RSAUtil::CancellationToken());
+    if (expect_true(lastProgress.primesFound >= 2 && lastProgress.candidatesTested > 0)) {
+        return 1;
+    }
+    RSAUtil::setParallelConfig({4, 0, 0, 512});
+    lastProgress = {};
+    RSAUtil::generatePemKeyPair(1024, 2, [&](const RSAUtil::KeyGenProgress& update) { lastProgress = update; },
+                                RSAUtil::CancellationToken());
+    if (expect_true(lastProgress.primesFound == 2)) {
+        return 1;
+    }
+    // A throwing progress callback aborts the search and reaches the caller without crossing OpenSSL.
+    for (unsigned threads : {1u, 4u}) {
+        RSAUtil::setParallelConfig({threads, 0, 0, 512});
+        bool rethrown = false;
+        try {
+            RSAUtil::generatePemKeyPair(1024, 2, [](const RSAUtil::KeyGenProgress& update) {
+                if (update.candidatesTested >= 3) {
+                    throw std::logic_error("progress callback failed");
+                }
+            }, RSAUtil::CancellationToken());
+        } catch (const std::logic_error&) {
+            rethrown = true;
+        }
+        if (expect_true(rethrown)) {
+            return 1;
+        }
+    }
+    RSAUtil::setParallelConfig({});
+    if (expect_throws([] {
+            RSAUtil::generateKeyPair([](const RSAUtil::KeyGenProgress&) { throw std::logic_error("progress callback failed"); },
+                                     RSAUtil::CancellationToken());
+        })) {
+        return 1;
+    }
+    for (unsigned threads : {1u, 4u}) {
+        RSAUtil::setParallelConfig({threads, 0, 0, 512});
+        const RSAUtil::CancellationToken token;
+        const auto started = std::chrono::steady_clock::now();
+        std::thread canceller([token] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            token.cancel();
+        });
+        bool cancelled = false;
+        try {
+            RSAUtil::generatePemKeyPair(8192, 2, RSAUtil::KeyGenProgressCallback(), token);
+        } catch (const RSAUtil::OperationCancelled&) {
+            cancelled = true;
+        }
+        canceller.join();
+        if (expect_true(cancelled && std::chrono::steady_clock::now() - started < std::chrono::seconds(5))) {
+            return 1;
+        }
+    }
+    RSAUtil::setParallelConfig({});
+    const RSAUtil::CancellationToken cancelledToken;
+    cancelledToken.cancel();
+    if (expect_throws([&] { RSAUtil::generateKeyPair(RSAUtil::KeyGenProgressCallback(), cancelledToken); })) {
+        return 1;
+    }
+
+    // The key pool refills in the background and hands unused keys over through its spool exactly once.
+    const std::filesystem::path spool = std::filesystem::temp_directory_path() / "rsa_util_tests_pool.pem";
+    std::filesystem::remove(spool);
+    RSAUtil::KeyPoolOptions poolOptions;
+    poolOptions.capacity = 2;
+    poolOptions.lowWaterMark = 1;
+    poolOptions.spoolPath = spool.string();
+    std::string pooledPem;
+    {
+        RSAUtil::KeyPool pool(poolOptions);
+        pool.fill(1024);
+        const RSAUtil::PemKeyPair first = pool.acquire(1024);
+        if (expect_true(pool.available(1024) == 1 && RSAUtil::decryptBytes(RSAUtil::encryptBytes(bytes, first), first) == bytes)) {
+            return 1;
+        }
+        pooledPem = first.privateKeyPem;
+    }
+    if (expect_true(std::filesystem::exists(spool))) {
+        return 1;
+    }
+#if !defined(_WIN32)
+    const std::filesystem::perms spoolPerms = std::filesystem::status(spool).permissions();
+    if (expect_true((spoolPerms & (std::filesystem::perms::group_all | std::filesystem::perms::others_all)) ==
+                    std::filesystem::perms::none)) {
+        return 1;
+    }
+#endif
+    {
+        // A pool for another prime count neither sees nor drops the two-prime keys.
+        RSAUtil::KeyPoolOptions threePrime = poolOptions;
+        threePrime.primes = 3;
+        RSAUtil::KeyPool other(threePrime);
+        if (expect_true(other.available(1024) == 0 && !std::filesystem::exists(spool))) {
+            return 1;
+        }
+    }
+    {
+        // Only one of two pools opened on the same spool gets its keys.
+        RSAUtil::KeyPool reloaded(poolOptions);
+        RSAUtil::KeyPool rival(poolOptions);
+        if (expect_true(reloaded.available(1024) + rival.available(1024) == 1 && !std::filesystem::exists(spool) &&
+                        reloaded.acquire(1024).privateKeyPem != pooledPem)) {
+            return 1;
+        }
+    }
+#if !defined(_WIN32)
+    {
+        std::ofstream(spool.string()) << "RSAUtil key pool v2\n";
+        std::filesystem::permissions(spool, std::filesystem::perms::others_read, std::filesystem::perm_options::add);
+        if (expect_throws([&] { RSAUtil::KeyPool exposed(poolOptions); }) || expect_true(std::filesystem::exists(spool))) {
+            return 1;
+        }
+    }
+#endif
+    std::filesystem::remove(spool);
+
+    // The legacy integer mode matches BN_mod_exp natively and still accepts moduli wider than 63 bits.
+    {
+        const RSAUtil::KeyPair legacy = RSAUtil::generateKeyPair();
+        std::string allBytes;
+        for (int i = 0; i < 259; ++i) { // every byte value, plus a partial lane group
+            allBytes += static_cast<char>(i);
+        }
+        const std::vector<long long> encrypted = RSAUtil::encryptText(allBytes, legacy);
+        RSAUtil::detail::UniqueBN expected(BN_new());
+        RSAUtil::detail::UniqueBN base(RSAUtil::detail::makeBNFromWord(200));
+        RSAUtil::detail::UniqueBNCTX bnCtx(BN_CTX_new());
+        BN_mod_exp(expected.get(), base.get(), RSAUtil::detail::makeBNFromDec(legacy.publicKey).get(),
+                   RSAUtil::detail::makeBNFromDec(legacy.modulus).get(), bnCtx.get());
+        if (expect_true(RSAUtil::decryptText(encrypted, legacy) == allBytes &&
+                        encrypted[200] == RSAUtil::detail::bnToLongLong(expected.get()) &&
+                        RSAUtil::detail::LegacyModExp(legacy.publicKey, legacy.modulus).native() == RSAUTIL_HAS_INT128 &&
+                        RSAUtil::encryptNumber(5, "3", "18446744073709551557") == 125)) {
+            return 1;
+        }
+        if (expect_throws([&] { RSAUtil::decryptText({std::stoll(legacy.modulus)}, legacy); })) {
+            return 1;
+        }
+        // Codebook hits must match the modexp path; a miss falls back to a real decrypt.
+        RSAUtil::setKeyCacheCapacity(RSAUtil::detail::kDefaultKeyCacheCapacity);
+        RSAUtil::clearKeyCache();
+        const RSAUtil::KeyCacheStats beforeCodebook = RSAUtil::keyCacheStats();
+        if (expect_true(RSAUtil::encryptText(allBytes, legacy) == encrypted &&
+                        RSAUtil::encryptNumber(7, legacy.publicKey, legacy.modulus) == encrypted[7] &&
+                        RSAUtil::keyCacheStats().size == 1 &&
+                        RSAUtil::keyCacheStats().misses - beforeCodebook.misses == 1)) {
+            return 1;
+        }
+        if (expect_throws([&] { RSAUtil::decryptText({2}, legacy); })) {
+            return 1;
+        }
+        // Packed values carry 7 bytes each behind a length frame; a dropped block breaks the frame.
+        std::vector<long long> packed = RSAUtil::encryptTextPacked(allBytes, legacy);
+        if (expect_true(packed.size() == 1 + (allBytes.size() + 6) / 7 &&
+                        RSAUtil::decryptTextPacked(packed, legacy) == allBytes &&
+                        RSAUtil::decryptTextPacked(RSAUtil::encryptTextPacked("", legacy), legacy).empty() &&
+                        RSAUtil::decryptTextPacked(RSAUtil::encryptTextPacked("seven!!", legacy), legacy) == "seven!!")) {
+            return 1;
+        }
+        // Narrow imported moduli pack fewer bytes per value.
+        const RSAUtil::KeyPair textbook{"17", "2753", "3233"};
+        if (expect_true(RSAUtil::packedBytesPerValue(textbook) == 1 &&
+                        RSAUtil::decryptTextPacked(RSAUtil::encryptTextPacked("hi", textbook), textbook) == "hi")) {
+            return 1;
+        }
+        packed.pop_back();
+        if (expect_throws([&] { RSAUtil::decryptTextPacked(packed, legacy); })) {
+            return 1;
+        }
+    }
+
+    if (expect_throws([] { RSAUtil::encryptBytes({1, 2, 3}, RSAUtil::PublicKey()); })) {
+        return 1;
+    }
+    if (expect_throws([] { RSAUtil::PublicKey("not a pem"); })) {
+        return 1;
+    }
+
+    return 0;
+}